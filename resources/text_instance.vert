@@ -0,0 +1,22 @@
+#version 330 core
+#extension GL_ARB_explicit_uniform_location : require
+
+layout(location = 0) in vec3 in_Position;
+layout(location = 1) in vec3 in_Color;
+layout(location = 2) in vec2 in_Texcoord;
+layout(location = 3) in vec4 instance_rect;
+layout(location = 4) in vec4 instance_uv;
+layout(location = 5) in vec3 instance_color;
+
+layout(location = 0) uniform mat4 mvp;
+
+out vec2 Texcoord;
+out vec3 color;
+
+void main(){
+    Texcoord = instance_uv.xy + in_Texcoord * instance_uv.zw;
+    color = instance_color;
+    vec3 pos = vec3(instance_rect.xy + in_Position.xy * instance_rect.zw, in_Position.z);
+    gl_Position = mvp * vec4(pos, 1.0);
+}
+
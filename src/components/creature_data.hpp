@@ -43,6 +43,7 @@ namespace ecs {
     struct CreatureData {
         int mutations = 0;
         int generations = 0;
+        uint64 lineage = 0;                         // phylogeny node of this creature
         string name = "";
 
         ubyte dna[config::CREATURE_DNA_SIZE];
@@ -58,8 +59,7 @@ namespace ecs {
         float brain_input_rate = 0.0f;
         float brain_leak_rate = 0.0f;
         float carnivore = 0.0f;                     // at 1.0f best meat digestion, at 0.0f best plant
-        // todo
-        float sex = 0.0f;                           // 0 no sex, 1 dna from 100% closest species member                    
+        float sex = 0.0f;                           // chance of a sexual birth, a uniform crossover with the closest species member
         float mutation_rate = 0.0f;                 // modify mutation chance
         
 
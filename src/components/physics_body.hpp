@@ -4,11 +4,19 @@
 
 namespace ecs {
 
+    // a body touching this one, other_vector points towards it
     struct CollisionInfo {
         CID other_id = INVALID_CID;              // physics body
         vec2 other_vector = vec2();
     };
 
+    // a touching pair as the solver finds it, normal points from b to a
+    struct ContactPair {
+        CID a;
+        CID b;
+        vec2 normal;
+    };
+
     struct PhysicsBody {
             // physical "constants"
             float friction = config::PHYSICS_FRICTION;
@@ -26,7 +34,14 @@ namespace ecs {
             float theta_old = 0.0f;
             float angular_acceleration = 0.0f;
             float torque_force = 0.0f;
-            
-            CollisionInfo last_collision;
+    };
+
+    // cell of the collision grid, one unit wide
+    // members are the bodies at World::region_members[first, first + count), the first home of them have their center in the cell
+    struct Region {
+        uint32 first = 0;
+        uint32 count = 0;
+        uint32 home = 0;
+        vec2 flow;
     };
 }
\ No newline at end of file
@@ -10,26 +10,41 @@ namespace config {
     static constexpr int SIM_MAX_CREATURES = 1000;
     static constexpr float SIM_DELTA = 1.0f / SIM_TICK_RATE;
     static constexpr uint32_t SIM_SEED = 0;
+    static constexpr float SIM_FRAME_BUDGET = 0.03f;        // seconds of ticking per rendered frame when the target speed is not reached
+    static constexpr float SIM_MAX_FRAME_TIME = 0.25f;      // owed real seconds above this are dropped
+    static constexpr int FRAME_ARENA_CHUNK = 1 << 20;       // bytes, scratch memory grows by this per thread
+    static constexpr int ALLOCATION_WARMUP_TICKS = 600;     // allocation free systems are checked from this tick on
 
     // PHYSICS
     static constexpr float PHYSICS_FRICTION = 350.0f;
     static constexpr float PHYSICS_ANGULAR_FRICTION = 100.0f;
     static constexpr float PHYSICS_COLLISION_FORCE = 0.08f;
-    static constexpr float PHYSICS_MAX_RADIUS = 0.5;
+    static constexpr float PHYSICS_MAX_RADIUS = 0.5;   // bodies up to this radius use the one unit grid, larger ones coarser levels
+    static constexpr int PHYSICS_GRID_LEVELS = 9;      // cells of level l are 2^l units wide, the last level covers the map
     static constexpr int PHYSICS_MAP_WIDTH = 200;
     static constexpr vec2 PHYSICS_MAP_CENTER = vec2(PHYSICS_MAP_WIDTH * 0.5f, PHYSICS_MAP_WIDTH * 0.5f);
     static constexpr float PHYSICS_MAP_BROWNIAN_FORCE = 0.002f;
     static constexpr float PHYSICS_MAP_BROWNIAN_TORQUE = 0.0002f;
     static constexpr float PHYSICS_MAP_CENTER_GRAVITY = 0.000f;
     static constexpr int PHYSICS_MAP_UPDATE_RATE = 60;
+    static constexpr int PHYSICS_STRIP_ROWS = 8;       // region rows per collision strip, at least 2
+    static constexpr int PHYSICS_MAX_CONTACTS = SIM_MAX_ENTITIES;  // touching pairs per tick recorded without allocating, about 700 seen at most
 
     // CREATURES
     static constexpr int CREATURE_DNA_SIZE = 1024;
     static constexpr int CREATURE_MAX_APPENDAGES = 16;
     static constexpr int CREATURE_GENERATOR_SEED = 13371339;
+    static constexpr int CREATURE_GENERATOR_THREADS = 2;        // background threads generating fetus phenotypes
+    static constexpr int CREATURE_GENERATOR_LATENCY = 4;        // ticks from birth until the phenotype is committed
+    static constexpr int CREATURE_GENERATOR_QUEUE = 128;        // fetuses in generation per world, the rest wait a tick
     static constexpr float CREATURE_KLEIBER_CONSTANT = 0.5f;
     static constexpr float CREATURE_METABOLIC_RATE = 0.0025f;
     static constexpr float CREATURE_MUTATION_RATE = 0.01f;
+    static constexpr int PHYLOGENY_PRUNE_INTERVAL = 600;    // ticks between dropping extinct branches
+    static constexpr int SPECIES_INTERVAL = 300;            // ticks between species clustering passes
+    static constexpr uint32_t SPECIES_DISTANCE = 256;       // max differing dna bits to a species representative
+    static constexpr float CREATURE_MATE_RADIUS = 5.0f;     // search radius for a mate at sexual birth
+    static constexpr uint32_t CREATURE_MATE_DISTANCE = 256; // max differing dna bits of a compatible mate
     static constexpr float CREATURE_BIRTH_ENERGY = 0.4f;
     static constexpr float CREATURE_BIRTH_COST = 0.6f;
     static constexpr float CREATURE_MIN_ENERGY = 0.0f;
@@ -51,6 +66,7 @@ namespace config {
     static constexpr float PLANT_GROWTH = 0.00005f;
     static constexpr float PLANT_BIRTH_ENERGY = 0.05f;
     static constexpr float PLANT_MAX_ENERGY = 0.35f;
+    static constexpr float FOOD_FIELD_DIFFUSION = 0.02f;    // share of the nutrient difference to each neighbour per tick, below 0.25
 
      // BRAIN
     static constexpr int BRAIN_SIZE = 26;
@@ -75,6 +91,39 @@ namespace config {
     static constexpr bool RENDER_RESIZABLE = true;
     static constexpr int RENDER_RESOLUTION_X = 1024;
     static constexpr int RENDER_RESOLUTION_Y = 768;
+    static constexpr int RENDER_DEBUG_POINTS = 4096;        // debug line points per frame, more are dropped
+    static constexpr float HEATMAP_DECAY = 0.97f;           // per tick, trail length of heatmap modes
+
+    // CAPTURE
+    static constexpr int CAPTURE_RESOLUTION_X = 1920;
+    static constexpr int CAPTURE_RESOLUTION_Y = 1080;
+    static constexpr int CAPTURE_INTERVAL = 10;             // ticks between captured frames
+    static constexpr int CAPTURE_PBO_COUNT = 3;             // readbacks in flight
+    static constexpr int CAPTURE_QUEUE_SIZE = 8;            // frames buffered for the writer thread
+    const string CAPTURE_DIRECTORY = "capture/";
+    const string CAPTURE_ENCODER = "";                     // rgb24 frames are piped here if set, e.g. "ffmpeg -f rawvideo -pix_fmt rgb24 -s 1920x1080 -r 30 -i - out.mp4"
+
+    // SOFTWARE RENDERING (headless)
+    static constexpr int RENDER_SOFTWARE_RESOLUTION = 1024;    // square image of the whole map
+    static constexpr int RENDER_SOFTWARE_INTERVAL = 1000;      // ticks between written images
+    const string RENDER_SOFTWARE_DIRECTORY = "capture/";
+
+    // BENCHMARK
+    static constexpr int BENCHMARK_TICKS = 600;             // measured ticks per macro scenario
+    static constexpr int BENCHMARK_WARMUP_TICKS = 100;      // at most this many unmeasured ticks until no fetus is left
+    const string BENCHMARK_OUTPUT = "benchmark.json";
+    static constexpr int TRACE_TICKS = 1000;                // recorded ticks if --ticks is not given
+
+    // ISLANDS
+    static constexpr int ISLAND_CREATURES = 1000;           // initial population of every island
+    static constexpr int ISLAND_MIGRATION_INTERVAL = 600;   // ticks between migrations, islands run independently in between
+    static constexpr int ISLAND_MIGRANTS = 5;               // creatures moved to the next island per migration
+    static constexpr int MIGRATION_PORT = 7777;             // default port of --coordinator
+
+    // POPULATION EXPORT
+    static constexpr int POPULATION_EXPORT_INTERVAL = 600;  // default ticks between snapshots of --export
+    static constexpr bool POPULATION_EXPORT_DELTA = true;   // xor rows against the previous creature and pack zero runs
+    const string POPULATION_EXPORT_DIRECTORY = "export/";
 
     // CAMERA
     static constexpr float CAM_X = 150.0f;
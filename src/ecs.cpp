@@ -5,96 +5,240 @@
 
 namespace ecs {
 
-    ComponentVector<PhysicsBody> physics_bodies;
-    ComponentVector<CreatureData> creature_data;
-    ComponentVector<ParticleData> particle_data;
+    thread_local World *world = nullptr;
 
-    std::array<Mesh, config::SIM_MAX_CREATURES> meshes;
+    void initialize(){
+        bindWorld(createWorld(config::SIM_SEED));
+    }
 
-    std::queue<ID> freeEntities;
-    ID entitiesAlive = 0;
-    CID cellsAlive = 0;
+    void cleanup(){
+        destroyWorld(world);
+        world = nullptr;
+    }
 
-    void initialize(){
-        for(ID id = 0; id < config::SIM_MAX_ENTITIES; id++){
-            freeEntities.push(id);
+    World* createWorld(uint32 seed){
+        World *w = new World();
+        w->physics_bodies.setCapacity(config::SIM_MAX_ENTITIES, config::SIM_MAX_ENTITIES);
+        w->creature_data.setCapacity(config::SIM_MAX_CREATURES, config::SIM_MAX_ENTITIES);
+        w->particle_data.setCapacity(config::SIM_MAX_ENTITIES, config::SIM_MAX_ENTITIES);
+        w->region_members.reserve(4 * config::SIM_MAX_ENTITIES);
+        w->contacts.reserve(2 * config::PHYSICS_MAX_CONTACTS);
+        w->contact_first.reserve(config::SIM_MAX_ENTITIES + 1);
+
+        World *old = world;
+        world = w;
+        clear();
+        seedRandom(seed);
+        world = old;
+        return w;
+    }
+
+    void destroyWorld(World *w){
+        for(int i = 0; i < config::SIM_MAX_CREATURES; i++){
+            if(w->meshes[i].vao != 0){
+                w->meshes[i].destroy();
+            }
         }
-        physics_bodies.setCapacity(config::SIM_MAX_ENTITIES, config::SIM_MAX_ENTITIES);
-        creature_data.setCapacity(config::SIM_MAX_CREATURES, config::SIM_MAX_ENTITIES);
-        particle_data.setCapacity(config::SIM_MAX_ENTITIES, config::SIM_MAX_ENTITIES);
+        delete w;
     }
 
-    void cleanup(){
+    void bindWorld(World *w){
+        world = w;
+    }
+
+    void seedRandom(uint32 seed){
+        // splitmix so neighbouring seeds give unrelated streams, state must not be 0
+        uint64 z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        world->random_state = z != 0 ? z : 1;
+    }
+
+    uint32 randomInt(){
+        // xorshift64*
+        uint64 x = world->random_state;
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        world->random_state = x;
+        return (uint32) ((x * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+
+    float randomFloat(float min, float max){
+        return min + (max - min) * ((randomInt() >> 8) * (1.0f / 16777216.0f));
+    }
+
+    vec2 randomVector(){
+        float phi = randomFloat(0.0f, PI * 2.0f);
+        return vec2(cos(phi), sin(phi));
+    }
+
+    void clear(){
+        world->physics_bodies.clear();
+        world->creature_data.clear();
+        world->particle_data.clear();
+        for(int i = 0; i < config::SIM_MAX_CREATURES; i++){
+            world->meshes[i].vertex_buffer.clear();
+            world->meshes[i].index_buffer.clear();
+        }
+
+        world->freeEntities = std::queue<ID>();
+        world->freeMeshes = std::queue<int>();
+        for(ID id = 0; id < config::SIM_MAX_ENTITIES; id++){
+            world->freeEntities.push(id);
+        }
         for(int i = 0; i < config::SIM_MAX_CREATURES; i++){
-            meshes[i].destroy();
+            world->freeMeshes.push(i);
+        }
+        world->entitiesAlive = 0;
+        world->cellsAlive = 0;
+        world->tick = 0;
+        world->flow_row = 0;
+        world->flow_counter = 0;
+        world->gestation_lineage = 0;
+        memset(world->nutrients, 0, sizeof(world->nutrients));
+        world->nutrients_front = 0;
+        // the grid is not rebuilt before the next physics update
+        for(int y = 0; y < config::PHYSICS_MAP_WIDTH; y++){
+            for(int x = 0; x < config::PHYSICS_MAP_WIDTH; x++){
+                world->regions[y][x].count = 0;
+                world->regions[y][x].home = 0;
+            }
+        }
+        for(Region &region : world->coarse_regions){
+            region.count = 0;
+            region.home = 0;
         }
+        memset(world->level_bodies, 0, sizeof(world->level_bodies));
+        world->contacts.clear();
+        world->contact_first.clear();
+        phylogeny::clear();
     }
 
     ID allocateCell(){
         // entity id management
-        if(cellsAlive >= config::SIM_MAX_CREATURES){
+        if(world->cellsAlive >= config::SIM_MAX_CREATURES){
             freeRandomCell();
         }
-        if(entitiesAlive >= config::SIM_MAX_ENTITIES){
+        if(world->entitiesAlive >= config::SIM_MAX_ENTITIES){
             freeRandomFood();
         }
         
-        ID id = freeEntities.front();
+        ID id = world->freeEntities.front();
         assert(id != INVALID_ID);
-        freeEntities.pop();
-        cellsAlive++;
-        entitiesAlive++;
+        world->freeEntities.pop();
+        world->cellsAlive++;
+        world->entitiesAlive++;
 
         // add components
-        physics_bodies.add(id);
-        creature_data.add(id);
+        world->physics_bodies.add(id);
+        world->creature_data.add(id);
+
+        // mesh slot, gpu buffers of the previous owner are reused on the next upload
+        assert(!world->freeMeshes.empty());
+        world->creature_data.vector[world->creature_data.cid_map[id]].mesh_id = world->freeMeshes.front();
+        world->freeMeshes.pop();
 
         return id;
     }
 
     ID allocateFood(){
-        if(entitiesAlive == config::SIM_MAX_ENTITIES){
+        if(world->entitiesAlive == config::SIM_MAX_ENTITIES){
             freeRandomFood();
         }
 
-        ID id = freeEntities.front();
-        freeEntities.pop();
-        entitiesAlive++;
+        ID id = world->freeEntities.front();
+        world->freeEntities.pop();
+        world->entitiesAlive++;
 
-        physics_bodies.add(id);
-        particle_data.add(id);
+        world->physics_bodies.add(id);
+        world->particle_data.add(id);
 
         return id;
     }
 
     void freeCell(ID id){
         // we trust that id is a cell
-        physics_bodies.remove(id);
-        creature_data.remove(id);
+        int mesh_id = world->creature_data.vector[world->creature_data.cid_map[id]].mesh_id;
+        world->meshes[mesh_id].vertex_buffer.clear();
+        world->meshes[mesh_id].index_buffer.clear();
+        world->freeMeshes.push(mesh_id);
+
+        world->physics_bodies.remove(id);
+        world->creature_data.remove(id);
 
-        freeEntities.push(id);
-        cellsAlive--;
-        entitiesAlive--;
+        world->freeEntities.push(id);
+        world->cellsAlive--;
+        world->entitiesAlive--;
     }
 
     void freeFood(ID id){
         // we trust that id is a food
-        physics_bodies.remove(id);
-        particle_data.remove(id);
+        world->physics_bodies.remove(id);
+        world->particle_data.remove(id);
 
-        freeEntities.push(id);
-        entitiesAlive--;
+        world->freeEntities.push(id);
+        world->entitiesAlive--;
     }
 
     void freeRandomCell(){
-        assert(creature_data.vector.size() > 0);
-        CID r = rand() % (creature_data.vector.size());
-        freeCell(creature_data.id_map[r]);
+        assert(world->creature_data.vector.size() > 0);
+        CID r = randomInt() % (world->creature_data.vector.size());
+        freeCell(world->creature_data.id_map[r]);
     }
 
     void freeRandomFood(){
-        assert(particle_data.vector.size() > 0);
-        CID r = rand() % (particle_data.vector.size());
-        freeFood(particle_data.id_map[r]);
+        assert(world->particle_data.vector.size() > 0);
+        CID r = randomInt() % (world->particle_data.vector.size());
+        freeFood(world->particle_data.id_map[r]);
+    }
+
+    int allocateFoods(int count, ID *ids){
+        count = MIN(count, (int)(config::SIM_MAX_ENTITIES - world->entitiesAlive));
+        if(count <= 0){
+            return 0;
+        }
+        for(int i = 0; i < count; i++){
+            ids[i] = world->freeEntities.front();
+            world->freeEntities.pop();
+        }
+        world->entitiesAlive += count;
+
+        world->physics_bodies.addBatch(ids, count);
+        world->particle_data.addBatch(ids, count);
+        return count;
+    }
+
+    void freeFoods(const ID *ids, int count){
+        world->physics_bodies.removeBatch(ids, count);
+        world->particle_data.removeBatch(ids, count);
+        for(int i = 0; i < count; i++){
+            world->freeEntities.push(ids[i]);
+        }
+        world->entitiesAlive -= count;
+    }
+
+    void freeRandomFoods(int count){
+        CID n = world->particle_data.vector.size();
+        count = MIN(count, (int)n);
+        if(count <= 0){
+            return;
+        }
+
+        // floyd's sampling, count distinct indices with one random number each
+        static thread_local std::vector<ubyte> picked;
+        static thread_local std::vector<ID> ids;
+        picked.assign(n, 0);
+        ids.clear();
+        for(CID j = n - count; j < n; j++){
+            CID r = randomInt() % (j + 1);
+            if(picked[r]){
+                r = j;
+            }
+            picked[r] = 1;
+            ids.push_back(world->particle_data.id_map[r]);
+        }
+        freeFoods(ids.data(), count);
     }
-}
\ No newline at end of file
+}
@@ -14,6 +14,7 @@ namespace ecs {
 #include "components/physics_body.hpp"
 #include "components/creature_data.hpp"
 #include "components/particle_data.hpp"
+#include "util/phylogeny.hpp"
 
 namespace ecs {
 
@@ -35,6 +36,12 @@ namespace ecs {
                 size_max = max_size;
             }
 
+            void clear(){
+                vector.clear();
+                id_map.clear();
+                std::fill(cid_map.begin(), cid_map.end(), INVALID_CID);
+            }
+
             void add(ID entity){
                 // same size vectors
                 assert(id_map.size() == vector.size());
@@ -62,21 +69,116 @@ namespace ecs {
                 id_map.resize(id_map.size()-1);
                 cid_map[entity] = INVALID_ID;
             }
-    };
 
-    extern ComponentVector<PhysicsBody> physics_bodies;
-    extern ComponentVector<CreatureData> creature_data;
-    extern ComponentVector<ParticleData> particle_data;
+            // appends all entities with a single resize
+            void addBatch(const ID *entities, size_t count){
+                assert(id_map.size() == vector.size());
+                assert(vector.size() + count <= size_max);
+                CID first = vector.size();
+                vector.resize(first + count);
+                id_map.insert(id_map.end(), entities, entities + count);
+                for(size_t i = 0; i < count; i++){
+                    cid_map[entities[i]] = first + i;
+                }
+            }
+
+            // removes distinct entities, only holes below the new size are filled from the tail
+            void removeBatch(const ID *entities, size_t count){
+                assert(id_map.size() == vector.size());
+                assert(count <= vector.size());
+                CID new_size = vector.size() - count;
+
+                // mark removed slots first so the tail scan can skip them
+                for(size_t i = 0; i < count; i++){
+                    CID index = cid_map[entities[i]];
+                    assert(index != INVALID_CID);
+                    assert(id_map[index] != INVALID_ID); // duplicate entity
+                    id_map[index] = INVALID_ID;
+                }
+
+                CID tail = new_size;
+                for(size_t i = 0; i < count; i++){
+                    CID index = cid_map[entities[i]];
+                    cid_map[entities[i]] = INVALID_CID;
+                    if(index >= new_size){
+                        continue;
+                    }
+                    while(id_map[tail] == INVALID_ID){
+                        tail++;
+                    }
+                    vector[index] = vector[tail];
+                    id_map[index] = id_map[tail];
+                    cid_map[id_map[index]] = index;
+                    tail++;
+                }
+
+                vector.resize(new_size);
+                id_map.resize(new_size);
+            }
+    };
 
-    extern std::array<Mesh, config::SIM_MAX_CREATURES> meshes;
+    // all state of one simulated island, systems act on the world bound to the calling thread
+    struct World {
+        ComponentVector<PhysicsBody> physics_bodies;
+        ComponentVector<CreatureData> creature_data;
+        ComponentVector<ParticleData> particle_data;
+
+        std::array<Mesh, config::SIM_MAX_CREATURES> meshes;
+
+        std::queue<ID> freeEntities;
+        std::queue<int> freeMeshes;
+        ID entitiesAlive = 0;
+        CID cellsAlive = 0;
+
+        uint64 tick = 0;
+        uint64 random_state = 1;
+
+        // physics
+        Region regions[config::PHYSICS_MAP_WIDTH][config::PHYSICS_MAP_WIDTH];
+        std::vector<CID> region_members;        // all regions back to back, a body is in up to four
+        std::vector<Region> coarse_regions;     // broadphase levels above the regions for large bodies, back to back
+        uint32 level_bodies[config::PHYSICS_GRID_LEVELS] = {};
+        std::vector<std::vector<ContactPair>> contact_pairs;    // per collision strip, the coarse levels last
+        std::vector<CollisionInfo> contacts;    // of the last update, body b touches contacts[contact_first[b], contact_first[b + 1])
+        std::vector<uint32> contact_first;
+        int flow_row = 0;
+        int flow_counter = 0;
+
+        // creatures_generator, every fetus up to this lineage was submitted for generation
+        uint64 gestation_lineage = 0;
+
+        // environment
+        float growth_rate = 5000.0f;
+        phylogeny::Tree phylogeny;
+        float nutrients[2][config::PHYSICS_MAP_WIDTH * config::PHYSICS_MAP_WIDTH];    // food field, front and back buffer
+        int nutrients_front = 0;
+    };
 
-    extern ID entitiesAlive;
-    extern CID cellsAlive;
+    extern thread_local World *world;
 
+    // creates and binds the default world
     void initialize();
 
     void cleanup();
 
+    World* createWorld(uint32 seed);
+
+    void destroyWorld(World *w);
+
+    void bindWorld(World *w);
+
+    // per world random stream, keeps worlds deterministic no matter which thread steps them
+    void seedRandom(uint32 seed);
+
+    uint32 randomInt();
+
+    float randomFloat(float min, float max);
+
+    vec2 randomVector();
+
+    // removes every entity, the world is left as after initialize()
+    void clear();
+
     ID allocateCell();
 
     ID allocateFood();
@@ -88,5 +190,14 @@ namespace ecs {
     void freeFood(ID id);
 
     void freeRandomFood();
+
+    // allocates up to count foods without evicting any, returns how many were written to ids
+    int allocateFoods(int count, ID *ids);
+
+    // ids must be distinct foods
+    void freeFoods(const ID *ids, int count);
+
+    // frees count distinct foods picked at random
+    void freeRandomFoods(int count);
 }
 
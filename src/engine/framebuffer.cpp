@@ -0,0 +1,40 @@
+#include "common.hpp"
+#include "framebuffer.hpp"
+
+void Framebuffer::create(int w, int h){
+    assert(fbo == 0);
+    width = w;
+    height = h;
+
+    glGenRenderbuffers(1, &color_rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, color_rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_rbo);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        cout << "Framebuffer incomplete\n";
+        abort();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::bind(){
+    assert(fbo != 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void Framebuffer::unbind(){
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Framebuffer::destroy(){
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &color_rbo);
+    fbo = 0;
+    color_rbo = 0;
+    width = 0;
+    height = 0;
+}
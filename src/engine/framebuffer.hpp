@@ -0,0 +1,15 @@
+#pragma once
+
+#include "glad/glad/glad.h"
+#include "common.hpp"
+
+struct Framebuffer {
+    GLuint fbo = 0, color_rbo = 0;
+    int width = 0, height = 0;
+
+    void create(int w, int h);
+    void bind();
+    void unbind();
+    void destroy();
+};
+
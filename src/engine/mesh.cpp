@@ -26,15 +26,19 @@ void Mesh::upload(Hint hint, bool instanced){
         if(instanced){
             glGenBuffers(1, &ivbo);
             glBindBuffer(GL_ARRAY_BUFFER, ivbo);
-            glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-            glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) (2 * sizeof(float)));
-            glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) (3 * sizeof(float)));
-            glEnableVertexAttribArray(3);
-            glEnableVertexAttribArray(4);
-            glEnableVertexAttribArray(5);
-            glVertexAttribDivisor(3, 1);
-            glVertexAttribDivisor(4, 1); 
-            glVertexAttribDivisor(5, 1); 
+
+            int stride = 0;
+            for(int floats : instance_layout){
+                stride += floats;
+            }
+            int offset = 0;
+            for(size_t i = 0; i < instance_layout.size(); i++){
+                GLuint location = 3 + i;
+                glVertexAttribPointer(location, instance_layout[i], GL_FLOAT, GL_FALSE, stride * sizeof(float), (void*) (offset * sizeof(float)));
+                glEnableVertexAttribArray(location);
+                glVertexAttribDivisor(location, 1);
+                offset += instance_layout[i];
+            }
         }
 
         glBindVertexArray(0);
@@ -102,7 +106,7 @@ void Mesh::drawLines(){
     glBindVertexArray(0);
 }
 
-void Mesh::drawInstances(std::vector<float> &instance_data, Hint hint){
+void Mesh::uploadInstances(std::vector<float> &instance_data, Hint hint){
     assert(ivbo != 0);
 
     GLenum usage = GL_STATIC_DRAW;
@@ -128,17 +132,30 @@ void Mesh::drawInstances(std::vector<float> &instance_data, Hint hint){
         glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * instance_data.size(), instance_data.data());
     }
     glBindBuffer(GL_ARRAY_BUFFER, 0); 
+}
 
+void Mesh::drawInstances(){
+    assert(ivbo != 0);
     assert(vao != 0);
 
+    int stride = 0;
+    for(int floats : instance_layout){
+        stride += floats;
+    }
+
     glBindVertexArray(vao);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 
-    glDrawElementsInstanced(GL_TRIANGLES, ebo_size, GL_UNSIGNED_SHORT, NULL, ivbo_size / 6);
+    glDrawElementsInstanced(GL_TRIANGLES, ebo_size, GL_UNSIGNED_SHORT, NULL, ivbo_size / stride);
     glBindVertexArray(0);
 }
 
+void Mesh::drawInstances(std::vector<float> &instance_data, Hint hint){
+    uploadInstances(instance_data, hint);
+    drawInstances();
+}
+
 void Mesh::destroy(){
     glDeleteBuffers(1, &ebo);
     glDeleteBuffers(1, &vbo);
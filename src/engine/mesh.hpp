@@ -32,9 +32,14 @@ struct Mesh {
     VertexBuffer vertex_buffer;
     IndexBuffer index_buffer;
 
+    // floats per instance attribute, bound to locations 3, 4, 5, ...
+    std::vector<int> instance_layout = {2, 1, 3};
+
     void upload(Hint hint, bool instanced);
+    void uploadInstances(std::vector<float> &instance_data, Hint hint);
     void draw();
     void drawLines();
+    void drawInstances();
     void drawInstances(std::vector<float> &instance_data, Hint hint);
     void destroy();
 };
@@ -44,6 +44,15 @@ void Texture::create(string const &path, bool flip){
     assert(surf->format->BitsPerPixel = 32);
 }
 
+void Texture::create(int width, int height){
+    surf = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA32);
+    if(surf == nullptr){
+        cout << "couldn't create image" << endl;
+        abort();
+    }
+    SDL_LockSurface(surf);
+}
+
 void Texture::convert_black_to_alpha(){
     uint8_t *pixels = (uint8_t*) surf->pixels;
     int pitch = surf->pitch;
@@ -10,6 +10,7 @@ struct Texture {
     GLuint id = 0;
 
     void create(string const &path, bool flip);
+    void create(int width, int height);
     void load();
     uint8_t* get_pixels(int &pitch);
     void convert_black_to_alpha();
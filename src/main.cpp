@@ -8,26 +8,60 @@
 #include "systems/creatures_thinking.hpp"
 #include "systems/creatures.hpp"
 #include "systems/environment.hpp"
+#include "systems/food_field.hpp"
+#include "systems/heatmap.hpp"
 #include "systems/particles.hpp"
 #include "systems/physics.hpp"
 #include "systems/rendering.hpp"
+#include "systems/rendering_software.hpp"
+#include "util/benchmark.hpp"
+#include "util/capture.hpp"
+#include "util/islands.hpp"
+#include "util/migration.hpp"
+#include "util/population_export.hpp"
+#include "util/scheduler.hpp"
+#include "util/species.hpp"
+#include "util/system_graph.hpp"
+#include "util/thread_pool.hpp"
+#include "util/trace.hpp"
 
 static string TERMINAL_COLOR = "\033[1;36m";
 
+// --headless runs the simulation without window or gpu, images come from the software renderer
+static bool headless = false;
+static uint64 headless_ticks = 0;   // 0 runs forever
+static bool benchmark_mode = false;
+static string benchmark_path = config::BENCHMARK_OUTPUT;
+static int exit_code = 0;
+static int island_count = 0;
+
+static void buildSystemGraph();
 
 void initialize(){
-    engine::initialize();
+    if(!headless){
+        engine::initialize();
+    }
 
     ecs::initialize();
+    thread_pool::initialize(0);
 
     creatures_generator::initialize();
     creatures_physics_IO::initialize();
     creatures_thinking::initialize();
     creatures::initialize();
     environment::initialize();
+    food_field::initialize();
+    heatmap::initialize();
     particles::initialize();
     physics::initialize();
-    rendering::initialize();
+    population_export::initialize();
+    species::initialize();
+    buildSystemGraph();
+    if(headless){
+        rendering_software::initialize();
+    }else{
+        rendering::initialize();
+    }
 
     srand(config::SIM_SEED);
 
@@ -41,35 +75,72 @@ void cleanup(){
     creatures_thinking::cleanup();
     creatures::cleanup();
     environment::cleanup();
+    food_field::cleanup();
+    heatmap::cleanup();
     particles::cleanup();
     physics::cleanup();
-    rendering::cleanup();
-    
-    engine::quit();
-    exit(0);
+    trace::cleanup();
+    migration::cleanup();
+    population_export::cleanup();
+    species::cleanup();
+    thread_pool::cleanup();
+    if(headless){
+        rendering_software::cleanup();
+    }else{
+        rendering::cleanup();
+        engine::quit();
+    }
+    exit(exit_code);
 
     cout << TERMINAL_COLOR + "[Main] cleanup" + TERMINAL_CLEAR << std::endl;
 }
 
 int processUI();
 
-bool update(float real_delta){
-    static uint64_t tick = 0;
+void step(){
+    system_graph::run(ecs::world->tick);
+    ecs::world->tick++;
+}
+
+static void buildSystemGraph(){
+    using namespace system_graph;
+    // the generator only touches fetuses, which nothing before creatures_physics_IO reads,
+    // running it before physics instead of after particles gives the same result and lets both overlap
+    // births allocate names, phylogeny nodes, free id queue blocks and fetus meshes, every other system is allocation free
+    add("environment", [](uint64 tick){ environment::update(tick); }, ALL, ALL, TRACED);
+    add("creatures_generator", [](uint64){ creatures_generator::update(); }, ENTITIES, CREATURES | BRAINS | MESHES, TRACED);
+    add("physics", [](uint64 tick){ physics::update(tick); }, ENTITIES, BODIES | REGIONS);
+    add("particles", [](uint64){ particles::update(); }, ENTITIES | CREATURES | REGIONS, PARTICLES);
+    add("creatures_thinking", [](uint64){ creatures_thinking::update(); }, ENTITIES | CREATURES, BRAINS);
+    add("creatures_physics_IO", [](uint64){ creatures_physics_IO::update(); }, ENTITIES | PARTICLES | REGIONS, BODIES | CREATURES | BRAINS | FOOD_FIELD);
+    add("heatmap", [](uint64){ heatmap::update(); }, ENTITIES | BODIES | CREATURES, HEATMAP, ALLOCATION_FREE);
+    build();
+}
+
+static void tick(){
+    step();
+    migration::update(ecs::world->tick);
+    population_export::update(ecs::world->tick);
+    species::update(ecs::world->tick);
+}
 
-    int state = processUI();
+void update(float real_delta){
+    if(headless){
+        tick();
+        rendering_software::update(real_delta, ecs::world->tick);
+        return;
+    }
 
-    if(!(state & 2)){
-        // if not paused
-        environment::update(tick);
-        physics::update(tick);
-        particles::update();
-        creatures_generator::update();
-        creatures_thinking::update();
-        creatures_physics_IO::update();
-        tick++;
+    bool paused = processUI() & 2;
+    if(paused){
+        scheduler::skipFrame();
+    }else{
+        // every owed tick that fits the frame budget, then a single render
+        while(scheduler::nextTick()){
+            tick();
+        }
     }
-    rendering::update(real_delta);
-    return state & 1;
+    rendering::update(real_delta, ecs::world->tick);
 }
 
 int processUI(){
@@ -120,29 +191,29 @@ int processUI(){
 
 
     // disable old ui source
-    if(old_ui_cid != ecs::INVALID_CID && old_ui_cid < ecs::cellsAlive){
-        ecs::creature_data.vector[old_ui_cid].ui_source = false;
+    if(old_ui_cid != ecs::INVALID_CID && old_ui_cid < ecs::world->cellsAlive){
+        ecs::world->creature_data.vector[old_ui_cid].ui_source = false;
         old_ui_cid = ecs::INVALID_CID;
     } 
     if(click){
         // disable old highlighted
-        if(old_highlighted_cid != ecs::INVALID_CID && old_highlighted_cid < ecs::cellsAlive){
-            ecs::creature_data.vector[old_highlighted_cid].highlighted = false;
+        if(old_highlighted_cid != ecs::INVALID_CID && old_highlighted_cid < ecs::world->cellsAlive){
+            ecs::world->creature_data.vector[old_highlighted_cid].highlighted = false;
             old_highlighted_cid = ecs::INVALID_CID;
         }
     }
 
     if(cid != ecs::INVALID_CID){
-        ecs::ID id = ecs::physics_bodies.id_map[cid];
+        ecs::ID id = ecs::world->physics_bodies.id_map[cid];
         assert(id != ecs::INVALID_ID);
-        ecs::CID creature_cid = ecs::creature_data.cid_map[id];
+        ecs::CID creature_cid = ecs::world->creature_data.cid_map[id];
         if(creature_cid != ecs::INVALID_CID){
             // enable new ui source if nothing highlighed
-            ecs::creature_data.vector[creature_cid].ui_source = true;
+            ecs::world->creature_data.vector[creature_cid].ui_source = true;
             old_ui_cid = creature_cid;
             if(click){
-                ecs::creature_data.vector[creature_cid].highlighted = true;
-                ecs::creature_data.vector[creature_cid].to_mesh = true;
+                ecs::world->creature_data.vector[creature_cid].highlighted = true;
+                ecs::world->creature_data.vector[creature_cid].to_mesh = true;
                 old_highlighted_cid = creature_cid;
             }
         }
@@ -165,10 +236,34 @@ int processUI(){
         rendering::setRenderMode(4);
     }
 
-    // FAST_FORWARD?
-    static bool ff = false;
+    // CYCLE HEATMAP MODE
+    if(input::getKeyState(input::KEY_0) == input::PRESSED){
+        heatmap::setMode(heatmap::NONE);
+    }
+    if(input::getKeyState(input::KEY_6) == input::PRESSED){
+        heatmap::setMode(heatmap::DENSITY);
+    }
+    if(input::getKeyState(input::KEY_7) == input::PRESSED){
+        heatmap::setMode(heatmap::CARNIVORE);
+    }
+    if(input::getKeyState(input::KEY_8) == input::PRESSED){
+        heatmap::setMode(heatmap::ENERGY);
+    }
+    if(input::getKeyState(input::KEY_9) == input::PRESSED){
+        heatmap::setMode(heatmap::SPECIES);
+    }
+    if(input::getKeyState(input::KEY_N) == input::PRESSED){
+        heatmap::setMode(heatmap::NUTRIENTS);
+    }
+
+    // SIMULATION SPEED
     if(input::getKeyState(input::KEY_F) == input::PRESSED){
-        ff = !ff;
+        scheduler::cycleSpeed();
+    }
+
+    // CAPTURE FRAMES
+    if(input::getKeyState(input::KEY_V) == input::PRESSED){
+        capture::setEnabled(!capture::isEnabled());
     }
 
     static bool pause = false;
@@ -184,41 +279,96 @@ int processUI(){
     // SET STATE INFO
     if(pause){
         rendering::setStateInfo("paused");
-    }else if(ff){
-        rendering::setStateInfo("fast forward");
     }else{
-        rendering::setStateInfo("normal");
+        char info[64];
+        float speed = scheduler::getSpeed();
+        if(speed == scheduler::SPEED_MAX){
+            snprintf(info, sizeof(info), "max, %.1fx", scheduler::getAchievedSpeed());
+        }else{
+            snprintf(info, sizeof(info), "%gx, %.1fx", speed, scheduler::getAchievedSpeed());
+        }
+        rendering::setStateInfo(info);
     }
 
-    return (int) ff + 2 * (int) pause;
+    return 2 * (int) pause;
 }
 
 int main(int argc, char *argv[]){
+    for(int i = 1; i < argc; i++){
+        string arg = argv[i];
+        if(arg == "--headless"){
+            headless = true;
+        }else if(arg == "--ticks" && i + 1 < argc){
+            headless_ticks = std::stoull(argv[++i]);
+        }else if(arg == "--benchmark"){
+            headless = true;
+            benchmark_mode = true;
+            if(i + 1 < argc && argv[i + 1][0] != '-'){
+                benchmark_path = argv[++i];
+            }
+        }else if(arg == "--islands" && i + 1 < argc){
+            headless = true;
+            island_count = std::stoi(argv[++i]);
+        }else if(arg == "--peer" && i + 1 < argc){
+            migration::initialize(argv[++i]);
+        }else if(arg == "--coordinator"){
+            int port = config::MIGRATION_PORT;
+            if(i + 1 < argc && argv[i + 1][0] != '-'){
+                port = std::stoi(argv[++i]);
+            }
+            migration::runCoordinator(port);
+            return 0;
+        }else if(arg == "--export"){
+            int ticks = config::POPULATION_EXPORT_INTERVAL;
+            if(i + 1 < argc && argv[i + 1][0] != '-'){
+                ticks = std::stoi(argv[++i]);
+            }
+            population_export::setInterval(ticks);
+        }else if(arg == "--food-field"){
+            food_field::setEnabled(true);
+        }else if(arg == "--record" && i + 1 < argc){
+            headless = true;
+            trace::record(argv[++i]);
+        }else if(arg == "--verify" && i + 1 < argc){
+            headless = true;
+            if(!trace::verify(argv[++i])){
+                return 1;
+            }
+        }
+    }
 
     initialize();
 
-    double accumulator = 0.0;
-    uint64 stampOld = engine::getMs();
-    double dt = 0.0f;
-    
-    bool fast_forward = false;
-    float delta = config::SIM_DELTA;
-   
-    while(true){
-        uint64 stampNew = engine::getMs();
-        dt = (double)(stampNew - stampOld) / 1000.0;
-        stampOld = stampNew;
+    if(island_count > 0){
+        islands::run(island_count, headless_ticks, step);
+        cleanup();
+    }
 
-        if(fast_forward){ // fast forward
-            fast_forward = update(dt);
+    if(benchmark_mode){
+        benchmark::run(benchmark_path, step, headless_ticks);
+        cleanup();
+    }
+
+    if(headless){
+        if(trace::getMode() == trace::VERIFY){
+            headless_ticks = trace::getTraceTicks();
+        }else if(trace::getMode() == trace::RECORD && headless_ticks == 0){
+            headless_ticks = config::TRACE_TICKS;
+        }
+
+        // no frame pacing, run as fast as possible
+        while((headless_ticks == 0 || ecs::world->tick < headless_ticks) && trace::isMatching()){
+            update(config::SIM_DELTA);
+        }
+        exit_code = trace::isMatching() ? 0 : 1;
+        cleanup();
+    }
+
+    while(true){
+        if(scheduler::beginFrame()){
+            update(scheduler::getFrameTime());
         }else{
-            accumulator += dt;
-             if(accumulator >= delta){
-                fast_forward = update(delta);
-                accumulator -= delta;
-            }else{
-                engine::sleep(1);
-            }
+            engine::sleep(1);
         }
     }
     cleanup();
@@ -2,6 +2,11 @@
 #include "ecs.hpp"
 #include "config.hpp"
 #include "engine/mesh.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
 
 
 namespace creatures_generator {
@@ -9,29 +14,75 @@ namespace creatures_generator {
     using namespace ecs;
 
     static float generateTrait(const ubyte *dna, uint32_t seed);
+    static void generatePhenotype(CreatureData &creature, Appendage::Type override);
     static void generateMesh(CID cid, int brain);
-    static void generateCreature(CID cid);
     static void initializeEyeMesh();
 
     static bool mesh_brain_continuous = false;
+    static Appendage::Type appendage_override = Appendage::NONE;
+
+    // phenotype of one fetus, generated on a worker and committed by the tick thread of its world
+    struct Gestation {
+        enum Status {
+            WAITING,
+            RUNNING,
+            DONE
+        };
+        World *world;
+        ID id;
+        uint64 lineage;
+        uint64 commit_tick;
+        Appendage::Type override;
+        Status status;
+        CreatureData phenotype;     // dna is copied in, everything genetic is generated next to it
+    };
+
+    static std::mutex mutex;
+    static std::condition_variable worker_signal;
+    static std::condition_variable done_signal;
+    static std::vector<std::thread> workers;
+    static bool workers_quit = false;
+    static std::deque<Gestation*> waiting;          // not yet picked up by a worker
+    static std::vector<Gestation*> in_flight;       // all worlds, submission order
+    static std::vector<std::unique_ptr<Gestation>> storage;
+    static std::vector<Gestation*> free_gestations;
+
+    static void gestate();
+    static void commit();
+    static void submit();
     
     void initialize(){
         initializeEyeMesh();
+        workers_quit = false;
+        for(int i = 0; i < config::CREATURE_GENERATOR_THREADS; i++){
+            workers.emplace_back(gestate);
+        }
     }
 
     void cleanup(){
-        
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            workers_quit = true;
+        }
+        worker_signal.notify_all();
+        for(std::thread &worker : workers){
+            worker.join();
+        }
+        workers.clear();
+        waiting.clear();
+        in_flight.clear();
+        free_gestations.clear();
+        storage.clear();
     }
 
     void update(){
-        for(size_t i = 0; i < creature_data.vector.size(); i++){
-            if(creature_data.vector[i].state == CreatureData::FETUS){
-                generateCreature(i);
-                creature_data.vector[i].state = CreatureData::READY;
-            }
+        commit();
+        submit();
 
-            if(creature_data.vector[i].to_mesh){
-                if(creature_data.vector[i].highlighted){
+        for(size_t i = 0; i < world->creature_data.vector.size(); i++){
+            // fetuses have no appendages to mesh yet
+            if(world->creature_data.vector[i].to_mesh && world->creature_data.vector[i].state != CreatureData::FETUS){
+                if(world->creature_data.vector[i].highlighted){
                     if(mesh_brain_continuous){
                         generateMesh(i, 2);
                     }else{
@@ -39,7 +90,7 @@ namespace creatures_generator {
                     }
                 }else{
                     generateMesh(i, 0);
-                    creature_data.vector[i].to_mesh = false;
+                    world->creature_data.vector[i].to_mesh = false;
                 }
             }
         }
@@ -49,6 +100,145 @@ namespace creatures_generator {
         mesh_brain_continuous = continuous;
     }
 
+    void setAppendageOverride(Appendage::Type type){
+        appendage_override = type;
+    }
+
+    /* ASYNC GENERATION */
+
+    static void gestate(){
+        while(true){
+            Gestation *g;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                worker_signal.wait(lock, []{ return workers_quit || !waiting.empty(); });
+                if(workers_quit){
+                    return;
+                }
+                g = waiting.front();
+                waiting.pop_front();
+                g->status = Gestation::RUNNING;
+            }
+            generatePhenotype(g->phenotype, g->override);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                g->status = Gestation::DONE;
+            }
+            done_signal.notify_all();
+        }
+    }
+
+    // fetuses born since the last submission in lineage order, a full queue leaves the rest for the next tick
+    static void submit(){
+        static thread_local std::vector<CID> fetuses;
+        fetuses.clear();
+        for(CID cid = 0; cid < world->creature_data.vector.size(); cid++){
+            const CreatureData &creature = world->creature_data.vector[cid];
+            if(creature.state == CreatureData::FETUS && creature.lineage > world->gestation_lineage){
+                fetuses.push_back(cid);
+            }
+        }
+        if(fetuses.empty()){
+            return;
+        }
+        std::sort(fetuses.begin(), fetuses.end(), [](CID a, CID b){
+            return world->creature_data.vector[a].lineage < world->creature_data.vector[b].lineage;
+        });
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // the queue limit counts this world only, so which fetuses wait does not depend on other worlds
+        int queued = 0;
+        for(Gestation *g : in_flight){
+            queued += g->world == world;
+        }
+        for(size_t i = 0; i < fetuses.size() && queued < config::CREATURE_GENERATOR_QUEUE; i++, queued++){
+            const CreatureData &creature = world->creature_data.vector[fetuses[i]];
+            if(free_gestations.empty()){
+                storage.emplace_back(new Gestation());
+                free_gestations.push_back(storage.back().get());
+            }
+            Gestation *g = free_gestations.back();
+            free_gestations.pop_back();
+            g->world = world;
+            g->id = world->creature_data.id_map[fetuses[i]];
+            g->lineage = creature.lineage;
+            g->commit_tick = world->tick + config::CREATURE_GENERATOR_LATENCY;
+            g->override = appendage_override;
+            g->status = Gestation::WAITING;
+            g->phenotype = CreatureData();
+            memcpy(g->phenotype.dna, creature.dna, config::CREATURE_DNA_SIZE);
+            waiting.push_back(g);
+            in_flight.push_back(g);
+            world->gestation_lineage = creature.lineage;
+        }
+        worker_signal.notify_all();
+    }
+
+    // phenotypes due this tick in submission order, unfinished ones are generated here or waited for
+    static void commit(){
+        static thread_local std::vector<Gestation*> due;
+        due.clear();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(Gestation *g : in_flight){
+                // a commit tick too far ahead was submitted before ecs::clear reset the tick, it is dropped now
+                bool stale = g->commit_tick > world->tick + config::CREATURE_GENERATOR_LATENCY;
+                if(g->world == world && (g->commit_tick <= world->tick || stale)){
+                    due.push_back(g);
+                }
+            }
+        }
+
+        for(Gestation *g : due){
+            bool stale = g->commit_tick > world->tick + config::CREATURE_GENERATOR_LATENCY;
+            bool generate = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if(g->status == Gestation::WAITING){
+                    waiting.erase(std::find(waiting.begin(), waiting.end(), g));
+                    g->status = Gestation::RUNNING;
+                    generate = !stale;
+                }else{
+                    done_signal.wait(lock, [g]{ return g->status == Gestation::DONE; });
+                }
+            }
+            if(generate){
+                generatePhenotype(g->phenotype, g->override);
+            }
+
+            // the fetus may have been evicted and its id reused since submission
+            CID cid = world->creature_data.cid_map[g->id];
+            if(cid != INVALID_CID && !stale){
+                CreatureData &creature = world->creature_data.vector[cid];
+                CreatureData &p = g->phenotype;
+                if(creature.state == CreatureData::FETUS && creature.lineage == g->lineage){
+                    // the fetus was not resubmitted since its lineage was passed, so a changed override or dna is generated here
+                    if(g->override != appendage_override || memcmp(creature.dna, p.dna, config::CREATURE_DNA_SIZE) != 0){
+                        p = CreatureData();
+                        memcpy(p.dna, creature.dna, config::CREATURE_DNA_SIZE);
+                        generatePhenotype(p, appendage_override);
+                    }
+                    memcpy(creature.appendages, p.appendages, sizeof(creature.appendages));
+                    memcpy(creature.neurons, p.neurons, sizeof(creature.neurons));
+                    creature.appendage_count = p.appendage_count;
+                    creature.size = p.size;
+                    creature.metabolic_rate = p.metabolic_rate;
+                    creature.color = p.color;
+                    creature.brain_input_rate = p.brain_input_rate;
+                    creature.brain_leak_rate = p.brain_leak_rate;
+                    creature.carnivore = p.carnivore;
+                    creature.sex = p.sex;
+                    creature.mutation_rate = p.mutation_rate;
+                    creature.state = CreatureData::READY;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            in_flight.erase(std::find(in_flight.begin(), in_flight.end(), g));
+            free_gestations.push_back(g);
+        }
+    }
+
     static inline int allele_at(const ubyte* dna, uint32 bit_index) {
         const uint32 byte_index = bit_index / 8;
         const uint32 bit = bit_index % 8;
@@ -90,11 +280,22 @@ namespace creatures_generator {
         return tanh_approx(trait) * 0.5f + 0.5f;
     }
 
-    static void generateCreature(CID cid){
+    float generateTraits(const ubyte *dna, uint32 seed, int count){
+        float sum = 0.0f;
+        for(int i = 0; i < count; i++){
+            sum += generateTrait(dna, seed + i);
+        }
+        return sum;
+    }
+
+    void generateCreature(CID cid){
+        generatePhenotype(world->creature_data.vector[cid], appendage_override);
+    }
 
-        uint32_t count = config::CREATURE_GENERATOR_SEED + 5;
+    // writes every genetic field of creature from its dna
+    static void generatePhenotype(CreatureData &creature, Appendage::Type override){
 
-        CreatureData &creature = creature_data.vector[cid];
+        uint32_t count = config::CREATURE_GENERATOR_SEED + 5;
 
         creature.brain_input_rate = config::BRAIN_INPUTRATE_MIN; 
         creature.brain_input_rate += (config::BRAIN_INPUTRATE_MAX - config::BRAIN_LEAKRATE_MIN) * generateTrait(creature.dna, count++);
@@ -140,6 +341,12 @@ namespace creatures_generator {
                     creature.appendages[i].type = Appendage::SPIKE;
                 }
             }
+            if(override != Appendage::NONE){
+                if(creature.appendages[i].type == Appendage::NONE){
+                    n++;
+                }
+                creature.appendages[i].type = override;
+            }
         }
         int k = 0;
         
@@ -359,7 +566,7 @@ namespace creatures_generator {
             for(int x = 0; x < config::BRAIN_SIZE; x++){
                 int nx = x + config::BRAIN_SYNAPSE_RADIUS;
                 int ny = y + config::BRAIN_SYNAPSE_RADIUS;
-                Neuron &neuron = creature_data.vector[cid].neurons[ny][nx];
+                Neuron &neuron = world->creature_data.vector[cid].neurons[ny][nx];
 
                 float npot = 0.2f + 0.8f * neuron.potential / config::BRAIN_ACTION_THRESHOLD;
                 npot = std::min(npot, 1.0f);
@@ -411,11 +618,11 @@ namespace creatures_generator {
     }
 
     static void generateMesh(CID cid, int mesh_brain){
-        CreatureData &creature = creature_data.vector[cid];
+        CreatureData &creature = world->creature_data.vector[cid];
         assert(creature.appendage_count > 0);
 
-        Mesh::VertexBuffer &vertices = ecs::meshes[creature.mesh_id].vertex_buffer;
-        Mesh::IndexBuffer &indices = ecs::meshes[creature.mesh_id].index_buffer;
+        Mesh::VertexBuffer &vertices = ecs::world->meshes[creature.mesh_id].vertex_buffer;
+        Mesh::IndexBuffer &indices = ecs::world->meshes[creature.mesh_id].index_buffer;
         if(vertices.size() > 0){
             // some fetus was killed during generation!
             vertices.clear();
@@ -10,4 +10,14 @@ namespace creatures_generator {
     void update();
 
     void setBrainMeshing(bool continuous);
+
+    // every appendage slot gets this type, NONE restores dna driven appendages
+    void setAppendageOverride(ecs::Appendage::Type type);
+
+    // ================== exposed for benchmarks =============
+
+    void generateCreature(ecs::CID cid);
+
+    // sum of count traits starting at seed
+    float generateTraits(const ubyte *dna, uint32 seed, int count);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "creatures_physics_IO.hpp"
 #include "ecs.hpp"
 #include "systems/physics.hpp"
+#include "systems/food_field.hpp"
 #include "util/debuglines.hpp"
 
 namespace creatures_physics_IO {
@@ -51,40 +52,53 @@ namespace creatures_physics_IO {
 
     void update(){
         
-        for(CID cid = 0; cid < creature_data.vector.size(); cid++){
-            CreatureData &creature = creature_data.vector[cid];
-            ID cid2 = physics_bodies.cid_map[creature_data.id_map[cid]];
-            PhysicsBody &body = physics_bodies.vector[cid2];
+        for(CID cid = 0; cid < world->creature_data.vector.size(); cid++){
+            CreatureData &creature = world->creature_data.vector[cid];
+            ID cid2 = world->physics_bodies.cid_map[world->creature_data.id_map[cid]];
+            PhysicsBody &body = world->physics_bodies.vector[cid2];
 
             if(creature.state & CreatureData::ALIVE){
                 float appendage_cost = handleAppendages(cid, cid2);
                 creature.energy -= getMetabolicRate(creature, appendage_cost) * config::SIM_DELTA;
 
-                // collision code
-                if(body.last_collision.other_id != INVALID_CID){
-                    ID other_id = physics_bodies.id_map[body.last_collision.other_id];
-                    CID other_creature_cid = creature_data.cid_map[other_id];
-                    CID other_particle_cid = particle_data.cid_map[other_id];
-                    
+                // collision code, feeding on everything touching the body
+                physics::ContactRange contacts = physics::getContacts(cid2);
+                if(!contacts.empty()){
 					creature.feeding = 0;
+                }
+                for(const CollisionInfo &contact : contacts){
+                    ID other_id = world->physics_bodies.id_map[contact.other_id];
+                    CID other_creature_cid = world->creature_data.cid_map[other_id];
+                    CID other_particle_cid = world->particle_data.cid_map[other_id];
+                    
                     if(other_creature_cid != INVALID_CID){
                         
-						CreatureData& other_creature = creature_data.vector[other_creature_cid];
+						CreatureData& other_creature = world->creature_data.vector[other_creature_cid];
                         if (creature.state & CreatureData::ALIVE && other_creature.state & CreatureData::ALIVE) {
 
-                            float our_feeding_rate = getFeedingRate(creature, body.last_collision.other_vector, true);
+                            float our_feeding_rate = getFeedingRate(creature, contact.other_vector, true);
 
                             other_creature.energy -= our_feeding_rate * config::SIM_DELTA;
                             creature.energy += our_feeding_rate * config::SIM_DELTA;
                             creature.feeding = 2;
                         }
                     }else if(other_particle_cid != INVALID_CID){
-                        float our_feeding_rate = getFeedingRate(creature, body.last_collision.other_vector, false);
+                        float our_feeding_rate = getFeedingRate(creature, contact.other_vector, false);
                         creature.energy += our_feeding_rate * config::SIM_DELTA;
-						creature.feeding = 1;
+						creature.feeding = MAX(creature.feeding, 1);
                     }
                     assert(other_particle_cid != INVALID_CID || other_creature_cid != INVALID_CID);
-                    body.last_collision.other_id = INVALID_CID;
+                }
+
+                // grazing on the nutrients under the body, plant food digestion like a particle
+                if(food_field::isEnabled()){
+                    float min_factor = config::CREATURE_MIN_DIGESTION;
+                    float grazing_rate = config::CREATURE_FEEDING_RATE * (min_factor + (1.0f - min_factor) * (1.0f - creature.carnivore)) * creature.size;
+                    float eaten = food_field::consume(body.position, grazing_rate * config::SIM_DELTA);
+                    creature.energy += eaten;
+                    if(creature.feeding != 2){
+                        creature.feeding = eaten > 0.0f ? 1 : 0;
+                    }
                 }
                 
                 if(creature.energy < config::CREATURE_MIN_ENERGY * creature.size * creature.size){
@@ -99,8 +113,8 @@ namespace creatures_physics_IO {
     }
 
     static float handleAppendages(CID cid_creature, CID cid_body){
-        CreatureData &creature = creature_data.vector[cid_creature];
-        PhysicsBody &body = physics_bodies.vector[cid_body];
+        CreatureData &creature = world->creature_data.vector[cid_creature];
+        PhysicsBody &body = world->physics_bodies.vector[cid_body];
 
 
         // sensors
@@ -145,19 +159,25 @@ namespace creatures_physics_IO {
                     physics::RaycastInfo info = physics::raycast(origin, normal, strength);
                     if(info.hit_id != INVALID_CID){
                         assert(info.hit_id != cid_body); // don't hit ourselves lol
-						ID id = ecs::physics_bodies.id_map[info.hit_id];
+						ID id = ecs::world->physics_bodies.id_map[info.hit_id];
 						assert(id != INVALID_ID);
-						CID cidc = ecs::creature_data.cid_map[id];
-						CID cidp = ecs::particle_data.cid_map[id];
+						CID cidc = ecs::world->creature_data.cid_map[id];
+						CID cidp = ecs::world->particle_data.cid_map[id];
 						if (cidc != INVALID_CID) {
 							creature.neurons[appendage.neuron_y][appendage.neuron_x].potential += 0.5f;
 						}
 						else if (cidp != INVALID_CID) {
 							creature.neurons[appendage.neuron_y][appendage.neuron_x+1].potential += 0.5f;
 						}
-						creature.neurons[appendage.neuron_y + 1][appendage.neuron_x - 1].potential += ecs::physics_bodies.vector[info.hit_id].radius;
+						creature.neurons[appendage.neuron_y + 1][appendage.neuron_x - 1].potential += ecs::world->physics_bodies.vector[info.hit_id].radius;
                     }
                     bool hit = info.hit_id != INVALID_CID;
+
+                    // no food particles to see, the plant channel sees the nutrients where the ray ends
+                    if(food_field::isEnabled() && food_field::getCapacity() > 0.0f){
+                        vec2 tip = origin + normal * (hit ? sqrtf(info.distanceSq) : strength);
+                        creature.neurons[appendage.neuron_y][appendage.neuron_x+1].potential += 0.5f * food_field::sample(tip) / food_field::getCapacity();
+                    }
                     
                     if(creature.highlighted){
                         if(info.distanceSq > 0.0f){
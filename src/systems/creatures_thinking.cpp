@@ -20,8 +20,8 @@ namespace creatures_thinking {
 		const float action_potential = config::BRAIN_ACTION_THRESHOLD;
 		const float delta = config::SIM_DELTA;
 
-        for(CID cid = 0; cid < creature_data.vector.size(); cid++){
-            CreatureData &creature = creature_data.vector[cid];
+        for(CID cid = 0; cid < world->creature_data.vector.size(); cid++){
+            CreatureData &creature = world->creature_data.vector[cid];
 			const float creature_leak_rate = creature.brain_leak_rate;
 			const float creature_input_rate = creature.brain_input_rate;
 
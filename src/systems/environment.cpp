@@ -2,24 +2,24 @@
 #include "ecs.hpp"
 #include "physics.hpp"
 #include "util/markov_name.hpp"
+#include "util/phylogeny.hpp"
+#include "util/species.hpp"
+#include "systems/food_field.hpp"
+#include "util/frame_arena.hpp"
 
 namespace environment {
 
     using namespace ecs;
 
-    static float growth_rate = 5000.0f;
-
-    static void spawnCreature(vec2 position);
     static ID reproduceCreature(ID creature);
+    static void crossover(CID mother_cid, vec2 position, ubyte *dna, std::vector<uint16> &changed_bits);
+    static int mutate(ubyte *dna, float bit_probability, std::vector<uint16> &changed_bits);
+    static ID placeCreature(vec2 position);
 
     void initialize(){
         markov_name::initialize("resources/species.txt");
 
-        for(int i = 0; i < 1000; i++){
-            float min_x = config::PHYSICS_MAP_WIDTH * 0.2f;
-            float max_x = config::PHYSICS_MAP_WIDTH * 0.8f;
-            spawnCreature(vec2(randf(min_x, max_x), randf(min_x, max_x)));
-        }
+        populate(1000);
 
         /*
 		for (int i = 0; i < 8000; i++) {
@@ -37,42 +37,67 @@ namespace environment {
 
     }
 
+    void populate(int creatures){
+        for(int i = 0; i < creatures; i++){
+            float min_x = config::PHYSICS_MAP_WIDTH * 0.2f;
+            float max_x = config::PHYSICS_MAP_WIDTH * 0.8f;
+            spawnCreature(vec2(randomFloat(min_x, max_x), randomFloat(min_x, max_x)));
+        }
+    }
+
     void update(uint64 tick){
+        food_field::update();
 
-        while(entitiesAlive - cellsAlive < growth_rate){
-            float minval = 0.2f * config::PHYSICS_MAP_WIDTH;
-            float maxval = 0.8f * config::PHYSICS_MAP_WIDTH;
-            spawnFood(vec2(randf(minval, maxval), randf(minval, maxval)));
-        }
-        
-        static std::vector<ID> reproduce_creatures;
-        static std::vector<ID> kill_creatures;
-        static std::vector<ID> kill_foods;
+        // the food field replaces plant particles, no particles are kept then
+        float plant_target = food_field::isEnabled() ? 0.0f : world->growth_rate;
+
+        static thread_local std::vector<ID> reproduce_creatures;
+        static thread_local std::vector<ID> kill_creatures;
+        static thread_local std::vector<ID> kill_foods;
+        static thread_local std::vector<ID> new_foods;
         kill_creatures.clear();
         kill_foods.clear();
         reproduce_creatures.clear();
 
-        for(CID cid = 0; cid < particle_data.vector.size(); cid++){
-            ID id = particle_data.id_map[cid];
-            CID body_cid = physics_bodies.cid_map[id];
-            PhysicsBody &body = physics_bodies.vector[body_cid];
-            assert(particle_data.vector[cid].energy > 0.0f);
-            body.radius = 0.5f * sqrt(particle_data.vector[cid].energy / config::PLANT_MAX_ENERGY);
+        // missing plants are allocated together, growth rate changes spawn thousands at once
+        int plant_deficit = (int)ceilf(plant_target - (world->entitiesAlive - world->cellsAlive));
+        if(plant_deficit > 0){
+            float minval = 0.2f * config::PHYSICS_MAP_WIDTH;
+            float maxval = 0.8f * config::PHYSICS_MAP_WIDTH;
+            new_foods.resize(plant_deficit);
+            int spawned = allocateFoods(plant_deficit, new_foods.data());
+            for(int i = 0; i < spawned; i++){
+                PhysicsBody &body = world->physics_bodies.vector[world->physics_bodies.cid_map[new_foods[i]]];
+                float x = randomFloat(minval, maxval);
+                float y = randomFloat(minval, maxval);
+                body.position = vec2(x, y);
+                body.position_old = body.position;
+            }
+        }
+
+        for(CID cid = 0; cid < world->particle_data.vector.size(); cid++){
+            ID id = world->particle_data.id_map[cid];
+            CID body_cid = world->physics_bodies.cid_map[id];
+            PhysicsBody &body = world->physics_bodies.vector[body_cid];
+            assert(world->particle_data.vector[cid].energy > 0.0f);
+            body.radius = 0.5f * sqrt(world->particle_data.vector[cid].energy / config::PLANT_MAX_ENERGY);
             body.mass = body.radius * body.radius * 20;
-            if(particle_data.vector[cid].dead){
-                kill_foods.push_back(particle_data.id_map[cid]);
+            if(world->particle_data.vector[cid].dead){
+                kill_foods.push_back(world->particle_data.id_map[cid]);
             }
         }
 
-        int plant_surplus = entitiesAlive - cellsAlive - growth_rate;
-        for(int i = 0; i < plant_surplus; i++){
-            CID r = rand() % (particle_data.vector.size());
-			kill_foods.push_back(particle_data.id_map[r]);
+        // dead plants go first so the surplus is sampled from living ones only, and before births
+        // so the creature cap can never evict a plant that is already queued
+        freeFoods(kill_foods.data(), kill_foods.size());
+        int plant_surplus = world->entitiesAlive - world->cellsAlive - plant_target;
+        if(plant_surplus > 0){
+            freeRandomFoods(plant_surplus);
         }
         
-        for(CID cid = 0; cid < creature_data.vector.size(); cid++){
-            ID id = creature_data.id_map[cid];
-            CreatureData &creature = creature_data.vector[cid];
+        for(CID cid = 0; cid < world->creature_data.vector.size(); cid++){
+            ID id = world->creature_data.id_map[cid];
+            CreatureData &creature = world->creature_data.vector[cid];
 
             switch(creature.state){
                 case CreatureData::FETUS:
@@ -83,8 +108,8 @@ namespace environment {
                     break;
                 case CreatureData::READY:
                     creature.state = CreatureData::ALIVE;
-                    physics_bodies.vector[physics_bodies.cid_map[id]].radius = 0.5f * creature.size;
-                    physics_bodies.vector[physics_bodies.cid_map[id]].mass = 0.25f * creature.size * creature.size;
+                    world->physics_bodies.vector[world->physics_bodies.cid_map[id]].radius = 0.5f * creature.size;
+                    world->physics_bodies.vector[world->physics_bodies.cid_map[id]].mass = 0.25f * creature.size * creature.size;
                     creature.energy = creature.size * creature.size * config::CREATURE_BIRTH_ENERGY;
                     break;
                 case CreatureData::BIRTH:
@@ -101,7 +126,8 @@ namespace environment {
             }
         }
 
-        std::vector<ID> skip_these;
+        frame_arena::Vector<ID> skip_these;
+        skip_these.reserve(reproduce_creatures.size());
         for(ID id : reproduce_creatures){
             bool skip = false;
             for(ID id2 : skip_these){
@@ -118,112 +144,225 @@ namespace environment {
         for(ID id : kill_creatures){
             freeCell(id);
         }
-        for(ID id : kill_foods){
-            freeFood(id);
+
+        if(tick % config::PHYLOGENY_PRUNE_INTERVAL == 0){
+            phylogeny::prune();
         }
     }
 
+    void setGrowthRate(float rate){
+        world->growth_rate = 0.0f;
+        addGrowthRate(rate);
+    }
+
     void addGrowthRate(float rate_delta){
-        growth_rate += rate_delta;
-        if (growth_rate < 0.0f) {
-            growth_rate = 0.0f;
+        world->growth_rate += rate_delta;
+        if (world->growth_rate < 0.0f) {
+            world->growth_rate = 0.0f;
         }
-        if (growth_rate > config::SIM_MAX_ENTITIES - config::SIM_MAX_CREATURES) {
-			growth_rate = config::SIM_MAX_ENTITIES - config::SIM_MAX_CREATURES;
+        if (world->growth_rate > config::SIM_MAX_ENTITIES - config::SIM_MAX_CREATURES) {
+			world->growth_rate = config::SIM_MAX_ENTITIES - config::SIM_MAX_CREATURES;
         }
     }
 
     float getGrowthRate(){
-        return growth_rate;
-    }
-
-    static int reserveCreatureMesh(CID creature_cid){
-        // find free mesh
-        bool taken_meshes[config::SIM_MAX_CREATURES] = {false};
-        for(CID cid = 0; cid < creature_data.vector.size(); cid++){
-            if(cid != creature_cid){
-                // avoid marking own default value 0
-                taken_meshes[creature_data.vector[cid].mesh_id] = true;
-            }
-        }
-        int index = -1;
-        for(int i = 0; i < config::SIM_MAX_CREATURES; i++){
-            if(!taken_meshes[i]){
-                index = i;
-            }
-        }
-        assert(index != -1);
-        return index;
+        return world->growth_rate;
     }
 
     static ID reproduceCreature(ID creature_id){
-        CID creature_cid = creature_data.cid_map[creature_id];
-        CID body_cid = physics_bodies.cid_map[creature_id];
-        CreatureData &creature = creature_data.vector[creature_cid];
-        PhysicsBody& body = physics_bodies.vector[body_cid];
+        CID creature_cid = world->creature_data.cid_map[creature_id];
+        CID body_cid = world->physics_bodies.cid_map[creature_id];
+        CreatureData &creature = world->creature_data.vector[creature_cid];
+        PhysicsBody& body = world->physics_bodies.vector[body_cid];
 
 		if (creature.state != CreatureData::ALIVE) {
 			cout << "OH NO reproduction fail :D" << endl;
 			return INVALID_ID;
 		}
 
-        // set up child dna + position
-        vec2 birth_position = body.position + randv() * body.radius * 1.1f;
-        ubyte birth_dna[config::CREATURE_DNA_SIZE];
-        memcpy(birth_dna, creature.dna, config::CREATURE_DNA_SIZE);
-        int mutation_count = (int) ((float)config::CREATURE_DNA_SIZE * config::CREATURE_MUTATION_RATE * creature.mutation_rate);
-        int generation_parent = creature.generations;
-        int mutations_parent = creature.mutations;
-        string name_parent = creature.name;
-        for(int i = 0; i < mutation_count; i++){
-            uint32 byte_index = rand() % config::CREATURE_DNA_SIZE;
-            uint32 bit_index = rand() % 8;
-            ubyte mutation = 1 << bit_index;
-            birth_dna[byte_index] ^= mutation;
-        }
-
-        // spawn child
-        ID id = allocateCell(); // todo terrible bug if this messes up the ID order by removing alive cell
-        PhysicsBody &body2 = physics_bodies.vector[physics_bodies.cid_map[id]];
-        CreatureData &creature2 = creature_data.vector[creature_data.cid_map[id]];
-        memcpy(creature2.dna, birth_dna, config::CREATURE_DNA_SIZE);
-        creature2.name = name_parent;
-        if (rand() % 100 == 69) {
+        vec2 mother_position = body.position;
+        vec2 birth_position = body.position + randomVector() * body.radius * 1.1f;
+        bool sexual = randomFloat(0.0f, 1.0f) < creature.sex;
+
+        // spawn child first, a full world evicts a random creature and moves components around,
+        // so the parent is looked up again and the dna is written straight into the child
+        ID id = allocateCell();
+        creature_cid = world->creature_data.cid_map[creature_id];
+        if(id == creature_id || creature_cid == INVALID_CID){
+            // the parent was the evicted one, with no other free id left the child got its id back
+            freeCell(id);
+            return INVALID_ID;
+        }
+        CreatureData &parent = world->creature_data.vector[creature_cid];
+        PhysicsBody &body2 = world->physics_bodies.vector[world->physics_bodies.cid_map[id]];
+        CreatureData &creature2 = world->creature_data.vector[world->creature_data.cid_map[id]];
+        memcpy(creature2.dna, parent.dna, config::CREATURE_DNA_SIZE);
+
+        static thread_local std::vector<uint16> changed_bits;
+        changed_bits.clear();
+        if(sexual){
+            // bits taken from the mate are recorded like mutations, the mother stays the phylogeny parent
+            crossover(creature_cid, mother_position, creature2.dna, changed_bits);
+        }
+        float bit_probability = config::CREATURE_MUTATION_RATE * parent.mutation_rate / 8.0f;
+        int mutation_count = mutate(creature2.dna, bit_probability, changed_bits);
+
+        creature2.name = parent.name;
+        if (randomInt() % 100 == 69) {
             markov_name::mutateWord(creature2.name);
         }
-        creature2.mutations = mutations_parent + mutation_count;
-        creature2.generations = generation_parent + 1;
+        creature2.mutations = parent.mutations + mutation_count;
+        creature2.generations = parent.generations + 1;
+        creature2.lineage = phylogeny::recordBirth(parent.lineage, world->tick, changed_bits.data(), changed_bits.size());
         body2.position = birth_position;
         body2.position_old = birth_position;
-        creature2.mesh_id = reserveCreatureMesh(creature_data.cid_map[id]);
         creature2.state = CreatureData::FETUS;
 
         return id;
     }
 
-    static void spawnCreature(vec2 position){
+    static void crossover(CID mother_cid, vec2 position, ubyte *dna, std::vector<uint16> &changed_bits){
+        const ubyte *mother_dna = world->creature_data.vector[mother_cid].dna;
+
+        // nearest alive creature with similar dna, the dna check only runs for bodies closer than the best so far
+        CID mate_body = physics::findNearestBody(position, config::CREATURE_MATE_RADIUS, [&](CID body_cid){
+            CID cid = world->creature_data.cid_map[world->physics_bodies.id_map[body_cid]];
+            if(cid == INVALID_CID || cid == mother_cid){
+                return false;
+            }
+            const CreatureData &mate = world->creature_data.vector[cid];
+            return mate.state == CreatureData::ALIVE && species::distance(mother_dna, mate.dna) <= config::CREATURE_MATE_DISTANCE;
+        });
+        if(mate_body == INVALID_CID){
+            return;
+        }
+        const ubyte *mate_dna = world->creature_data.vector[world->creature_data.cid_map[world->physics_bodies.id_map[mate_body]]].dna;
+
+        // uniform crossover a word at a time, set mask bits come from the mate
+        for(int i = 0; i < config::CREATURE_DNA_SIZE; i += 8){
+            uint64 mother_word;
+            uint64 mate_word;
+            memcpy(&mother_word, dna + i, 8);
+            memcpy(&mate_word, mate_dna + i, 8);
+            uint64 mask = randomInt();
+            mask = (mask << 32) | randomInt();
+            uint64 changed = (mother_word ^ mate_word) & mask;
+            if(changed == 0){
+                continue;
+            }
+            mother_word ^= changed;
+            memcpy(dna + i, &mother_word, 8);
+            // bit k of a little endian word is bit k % 8 of byte i + k / 8
+            for(int k = 0; k < 64; k++){
+                if((changed >> k) & 1){
+                    changed_bits.push_back(i * 8 + k);
+                }
+            }
+        }
+    }
+
+    static int mutate(ubyte *dna, float bit_probability, std::vector<uint16> &changed_bits){
+        static constexpr int BITS = config::CREATURE_DNA_SIZE * 8;
+        if(bit_probability <= 0.0f){
+            return 0;
+        }
+
+        // every bit flips with bit_probability, geometric skips jump straight to the next flipped bit
+        // and flips of one 64 bit word are applied together
+        double log_keep = log(1.0 - MIN((double)bit_probability, 0.5));
+        int flips = 0;
+        int word = -1;
+        uint64 mask = 0;
+        auto apply = [&](){
+            if(word != -1){
+                uint64 w;
+                memcpy(&w, dna + word * 8, 8);
+                w ^= mask;
+                memcpy(dna + word * 8, &w, 8);
+            }
+        };
+
+        double bit = -1.0;
+        while(true){
+            double u = (randomInt() + 0.5) / 4294967296.0;
+            bit += 1.0 + floor(log(u) / log_keep);
+            if(bit >= BITS){
+                break;
+            }
+            int b = (int)bit;
+            if(b / 64 != word){
+                apply();
+                word = b / 64;
+                mask = 0;
+            }
+            // bit k of a little endian word is bit k % 8 of byte k / 8, same numbering as byte * 8 + bit
+            mask |= (uint64)1 << (b % 64);
+            changed_bits.push_back(b);
+            flips++;
+        }
+        apply();
+        return flips;
+    }
+
+    static ID placeCreature(vec2 position){
         ID id = allocateCell();
 
-        PhysicsBody &body = physics_bodies.vector[physics_bodies.cid_map[id]];
-        CreatureData &creature = creature_data.vector[creature_data.cid_map[id]];
+        PhysicsBody &body = world->physics_bodies.vector[world->physics_bodies.cid_map[id]];
+        body.position = position;
+        body.position_old = position;
+        return id;
+    }
+
+    void spawnCreature(vec2 position){
+        ID id = placeCreature(position);
+
+        CreatureData &creature = world->creature_data.vector[world->creature_data.cid_map[id]];
         for(int i = 0; i < config::CREATURE_DNA_SIZE; i++){
-            creature.dna[i] = rand();
+            creature.dna[i] = randomInt();
         }
         creature.name = markov_name::generateWord(4, 16);
-        body.position = position;
-        body.position_old = position;
-        creature.mesh_id = reserveCreatureMesh(creature_data.cid_map[id]);
+        creature.lineage = phylogeny::recordBirth(phylogeny::INVALID_LINEAGE, world->tick, nullptr, 0);
     }
 
     void spawnFood(vec2 position){
         ID id = allocateFood();
 
-        //ParticleData &particle = particle_data.vector[particle_data.cid_map[id]];
-        PhysicsBody &body = physics_bodies.vector[physics_bodies.cid_map[id]];
+        //ParticleData &particle = world->particle_data.vector[world->particle_data.cid_map[id]];
+        PhysicsBody &body = world->physics_bodies.vector[world->physics_bodies.cid_map[id]];
 
         body.position = position;
         body.position_old = position;
     }
 
-    
+    void emigrate(int count, std::vector<Migrant> &migrants){
+        for(int i = 0; i < count && world->creature_data.vector.size() > 0; i++){
+            CID cid = randomInt() % world->creature_data.vector.size();
+            CreatureData &creature = world->creature_data.vector[cid];
+            if(creature.state != CreatureData::ALIVE){
+                continue;
+            }
+            Migrant migrant;
+            memcpy(migrant.dna, creature.dna, config::CREATURE_DNA_SIZE);
+            migrant.name = creature.name;
+            migrant.generations = creature.generations;
+            migrant.mutations = creature.mutations;
+            migrants.push_back(migrant);
+            freeCell(world->creature_data.id_map[cid]);
+        }
+    }
+
+    void immigrate(const std::vector<Migrant> &migrants){
+        float min_x = config::PHYSICS_MAP_WIDTH * 0.2f;
+        float max_x = config::PHYSICS_MAP_WIDTH * 0.8f;
+        for(const Migrant &migrant : migrants){
+            ID id = placeCreature(vec2(randomFloat(min_x, max_x), randomFloat(min_x, max_x)));
+            CreatureData &creature = world->creature_data.vector[world->creature_data.cid_map[id]];
+            memcpy(creature.dna, migrant.dna, config::CREATURE_DNA_SIZE);
+            creature.name = migrant.name;
+            creature.generations = migrant.generations;
+            creature.mutations = migrant.mutations;
+            // ancestry from another world does not carry over, migrants root a new tree
+            creature.lineage = phylogeny::recordBirth(phylogeny::INVALID_LINEAGE, world->tick, nullptr, 0);
+        }
+    }
 }
\ No newline at end of file
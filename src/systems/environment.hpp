@@ -11,9 +11,27 @@ namespace environment {
 
     void update(uint64 tick);
 
+    // spawns creatures at random positions into the bound world
+    void populate(int creatures);
+
     // EXTRA FUNCTIONS
 
     void spawnFood(vec2 position);
+    void spawnCreature(vec2 position);
+    void setGrowthRate(float rate);
     void addGrowthRate(float rate_delta);
     float getGrowthRate();
+
+    // genome and lineage of a creature moving between worlds, it is regrown as a fetus
+    struct Migrant {
+        ubyte dna[config::CREATURE_DNA_SIZE];
+        string name;
+        int generations = 0;
+        int mutations = 0;
+    };
+
+    // removes up to count random alive creatures of the bound world
+    void emigrate(int count, std::vector<Migrant> &migrants);
+
+    void immigrate(const std::vector<Migrant> &migrants);
 }
\ No newline at end of file
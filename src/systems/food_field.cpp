@@ -0,0 +1,116 @@
+#include "systems/food_field.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FIELD_SSE2
+#endif
+
+namespace food_field {
+
+    using namespace ecs;
+
+    static constexpr int W = config::PHYSICS_MAP_WIDTH;
+
+    // plants used to spawn in the middle 60% of the map, the field only grows there
+    static float fertile[W * W];
+    static int fertile_cells = 0;
+    static bool enabled = false;
+
+    void initialize(){
+        int min = (int)(0.2f * W);
+        int max = (int)(0.8f * W);
+        fertile_cells = 0;
+        for(int y = 0; y < W; y++){
+            for(int x = 0; x < W; x++){
+                bool inside = x >= min && x < max && y >= min && y < max;
+                fertile[y * W + x] = inside ? 1.0f : 0.0f;
+                fertile_cells += inside;
+            }
+        }
+    }
+
+    void cleanup(){
+
+    }
+
+    void setEnabled(bool e){
+        enabled = e;
+    }
+
+    bool isEnabled(){
+        return enabled;
+    }
+
+    float getCapacity(){
+        // same total as growth_rate full grown plants
+        return world->growth_rate * config::PLANT_MAX_ENERGY / fertile_cells;
+    }
+
+    static inline int cellIndex(vec2 position){
+        int x = (int)position.x;
+        int y = (int)position.y;
+        if(x < 0 || y < 0 || x >= W || y >= W){
+            return -1;
+        }
+        return y * W + x;
+    }
+
+    float sample(vec2 position){
+        int i = cellIndex(position);
+        return i >= 0 ? world->nutrients[world->nutrients_front][i] : 0.0f;
+    }
+
+    float consume(vec2 position, float amount){
+        int i = cellIndex(position);
+        if(i < 0){
+            return 0.0f;
+        }
+        float *n = world->nutrients[world->nutrients_front];
+        float eaten = MIN(amount, n[i]);
+        n[i] -= eaten;
+        return eaten;
+    }
+
+    void update(){
+        if(!enabled){
+            return;
+        }
+
+        // per fertile cell growth so the whole field grows as fast as growth_rate plants would
+        const float growth = world->growth_rate * config::PLANT_GROWTH / fertile_cells;
+        const float capacity = getCapacity();
+        const float diffusion = config::FOOD_FIELD_DIFFUSION;
+        const float *n = world->nutrients[world->nutrients_front];
+        float *next = world->nutrients[world->nutrients_front ^ 1];
+
+        // border cells are never fertile and stay empty
+        for(int y = 1; y < W - 1; y++){
+            int x = 1;
+#ifdef FIELD_SSE2
+            const __m128 d = _mm_set1_ps(diffusion);
+            const __m128 g = _mm_set1_ps(growth);
+            const __m128 c = _mm_set1_ps(capacity);
+            const __m128 four = _mm_set1_ps(4.0f);
+            for(; x + 4 <= W - 1; x += 4){
+                int i = y * W + x;
+                __m128 center = _mm_loadu_ps(n + i);
+                __m128 neighbours = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(n + i - 1), _mm_loadu_ps(n + i + 1)),
+                                               _mm_add_ps(_mm_loadu_ps(n + i - W), _mm_loadu_ps(n + i + W)));
+                __m128 laplace = _mm_sub_ps(neighbours, _mm_mul_ps(four, center));
+                __m128 value = _mm_add_ps(center, _mm_mul_ps(d, laplace));
+                value = _mm_add_ps(value, _mm_mul_ps(g, _mm_loadu_ps(fertile + i)));
+                _mm_storeu_ps(next + i, _mm_min_ps(value, c));
+            }
+#endif
+            for(; x < W - 1; x++){
+                int i = y * W + x;
+                float laplace = n[i - 1] + n[i + 1] + n[i - W] + n[i + W] - 4.0f * n[i];
+                float value = n[i] + diffusion * laplace + growth * fertile[i];
+                next[i] = MIN(value, capacity);
+            }
+        }
+        world->nutrients_front ^= 1;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "engine/common.hpp"
+#include "ecs.hpp"
+
+/* nutrient grid on the physics regions that replaces food particles when enabled, grows and diffuses every tick */
+namespace food_field {
+
+    void initialize();
+
+    void cleanup();
+
+    void update();
+
+    // must be set before the first tick, the world then never spawns food particles
+    void setEnabled(bool enabled);
+
+    bool isEnabled();
+
+    // nutrients of the cell at position, in plant energy
+    float sample(vec2 position);
+
+    // removes up to amount from the cell at position, returns the amount eaten
+    float consume(vec2 position, float amount);
+
+    // nutrients of a saturated fertile cell at the current growth rate
+    float getCapacity();
+}
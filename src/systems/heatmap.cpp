@@ -0,0 +1,167 @@
+#include "systems/heatmap.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "systems/food_field.hpp"
+
+namespace heatmap {
+
+    using namespace ecs;
+
+    static constexpr int W = config::PHYSICS_MAP_WIDTH;
+
+    struct Fields {
+        float density[W * W];
+        float creatures[W * W];
+        float carnivore[W * W];
+        float energy[W * W];
+        float red[W * W];
+        float green[W * W];
+        float blue[W * W];
+    };
+
+    static Fields fields;
+    static Mode mode = NONE;
+
+    static void clear();
+
+    void initialize(){
+        clear();
+    }
+
+    void cleanup(){
+
+    }
+
+    static void clear(){
+        memset(&fields, 0, sizeof(fields));
+    }
+
+    static inline int regionIndex(vec2 position){
+        int x = (int)position.x;
+        int y = (int)position.y;
+        if(x < 0 || y < 0 || x >= W || y >= W){
+            return -1;
+        }
+        return y * W + x;
+    }
+
+    void update(){
+        if(mode == NONE){
+            return;
+        }
+
+        // decay
+        const float decay = config::HEATMAP_DECAY;
+        float *all = (float*) &fields;
+        const int n = sizeof(fields) / sizeof(float);
+        for(int i = 0; i < n; i++){
+            all[i] *= decay;
+        }
+
+        // accumulate
+        for(CID cid = 0; cid < world->physics_bodies.vector.size(); cid++){
+            int r = regionIndex(world->physics_bodies.vector[cid].position);
+            if(r >= 0){
+                fields.density[r] += 1.0f;
+            }
+        }
+
+        for(CID cid = 0; cid < world->creature_data.vector.size(); cid++){
+            CreatureData &creature = world->creature_data.vector[cid];
+            if(!(creature.state & CreatureData::ALIVE)){
+                continue;
+            }
+            int r = regionIndex(world->physics_bodies.vector[world->physics_bodies.cid_map[world->creature_data.id_map[cid]]].position);
+            if(r < 0){
+                continue;
+            }
+            fields.creatures[r] += 1.0f;
+            fields.carnivore[r] += creature.carnivore;
+            fields.energy[r] += creature.energy / (creature.size * creature.size * config::CREATURE_MAX_ENERGY);
+            fields.red[r] += creature.color.r;
+            fields.green[r] += creature.color.g;
+            fields.blue[r] += creature.color.b;
+        }
+    }
+
+    void setMode(Mode m){
+        assert(m >= NONE && m < MODE_TOTAL);
+        if(mode == NONE && m != NONE){
+            // start accumulating from an empty map
+            clear();
+        }
+        mode = m;
+    }
+
+    Mode getMode(){
+        return mode;
+    }
+
+    static inline void writePixel(ubyte *pixel, vec3 color, float alpha){
+        pixel[0] = (ubyte)(255.0f * CLAMP(color.r, 0.0f, 1.0f));
+        pixel[1] = (ubyte)(255.0f * CLAMP(color.g, 0.0f, 1.0f));
+        pixel[2] = (ubyte)(255.0f * CLAMP(color.b, 0.0f, 1.0f));
+        pixel[3] = (ubyte)(255.0f * CLAMP(alpha, 0.0f, 1.0f));
+    }
+
+    void colorize(ubyte *pixels, int pitch){
+        // steady state value of one permanent occupant
+        const float unit = 1.0f / (1.0f - config::HEATMAP_DECAY);
+
+        float max_density = unit;
+        if(mode == DENSITY){
+            for(int i = 0; i < W * W; i++){
+                max_density = MAX(max_density, fields.density[i]);
+            }
+        }
+        const float density_scale = 1.0f / logf(1.0f + max_density);
+
+        // read straight from the field, it needs no accumulation
+        const float *nutrients = world->nutrients[world->nutrients_front];
+        const float capacity = food_field::getCapacity();
+        const float inv_capacity = capacity > 0.0f ? 1.0f / capacity : 0.0f;
+
+        for(int y = 0; y < W; y++){
+            ubyte *row = pixels + (W - 1 - y) * pitch;
+            for(int x = 0; x < W; x++){
+                int r = y * W + x;
+                ubyte *pixel = row + x * 4;
+                float presence = fields.creatures[r];
+                float inv_presence = presence > 0.0f ? 1.0f / presence : 0.0f;
+                float alpha = presence / unit;
+
+                switch(mode){
+                    case DENSITY:
+                        {
+                        float d = logf(1.0f + fields.density[r]) * density_scale;
+                        writePixel(pixel, vec3(d, d * d, 0.25f * d), 1.0f);
+                        }
+                        break;
+                    case CARNIVORE:
+                        {
+                        float c = fields.carnivore[r] * inv_presence;
+                        writePixel(pixel, vec3(c, 1.0f - c, 0.0f), alpha);
+                        }
+                        break;
+                    case ENERGY:
+                        {
+                        float e = fields.energy[r] * inv_presence;
+                        writePixel(pixel, vec3(e, e, 1.0f - e), alpha);
+                        }
+                        break;
+                    case SPECIES:
+                        writePixel(pixel, vec3(fields.red[r], fields.green[r], fields.blue[r]) * inv_presence, alpha);
+                        break;
+                    case NUTRIENTS:
+                        {
+                        float n = nutrients[r] * inv_capacity;
+                        writePixel(pixel, vec3(0.2f * n, n, 0.1f * n), n);
+                        }
+                        break;
+                    default:
+                        writePixel(pixel, COLOR_BLACK, 0.0f);
+                }
+            }
+        }
+    }
+}
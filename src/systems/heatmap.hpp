@@ -0,0 +1,30 @@
+#pragma once
+#include "engine/common.hpp"
+#include "ecs.hpp"
+
+/* whole world overview fields on the physics region grid, decayed + accumulated every tick */
+namespace heatmap {
+
+    enum Mode {
+        NONE = 0,
+        DENSITY = 1,
+        CARNIVORE = 2,
+        ENERGY = 3,
+        SPECIES = 4,
+        NUTRIENTS = 5,
+        MODE_TOTAL
+    };
+
+    void initialize();
+
+    void cleanup();
+
+    void update();
+
+    void setMode(Mode mode);
+
+    Mode getMode();
+
+    // writes one RGBA pixel per region, first row is the top of the map
+    void colorize(ubyte *pixels, int pitch);
+}
@@ -2,6 +2,7 @@
 #include "ecs.hpp"
 #include "config.hpp"
 #include "creatures_physics_IO.hpp"
+#include "physics.hpp"
 
 namespace particles {
 
@@ -16,11 +17,10 @@ namespace particles {
     }
 
     void update(){
-        for(CID cid = 0; cid < particle_data.vector.size(); cid++){
+        for(CID cid = 0; cid < world->particle_data.vector.size(); cid++){
 
-            ParticleData &particle = particle_data.vector[cid];
-            CID cid2 = physics_bodies.cid_map[particle_data.id_map[cid]];
-            PhysicsBody &body = physics_bodies.vector[cid2];
+            ParticleData &particle = world->particle_data.vector[cid];
+            CID cid2 = world->physics_bodies.cid_map[world->particle_data.id_map[cid]];
 
             assert(particle.dead == false);
 
@@ -28,16 +28,17 @@ namespace particles {
                 particle.energy += config::PLANT_GROWTH;
             }
             
-            if(body.last_collision.other_id != INVALID_CID){
-                CID other_creature = creature_data.cid_map[physics_bodies.id_map[body.last_collision.other_id]];
-                vec2 normal = -body.last_collision.other_vector;
+            // eaten by every creature touching it
+            for(const CollisionInfo &contact : physics::getContacts(cid2)){
+                CID other_creature = world->creature_data.cid_map[world->physics_bodies.id_map[contact.other_id]];
+                vec2 normal = -contact.other_vector;
                 if(other_creature != INVALID_CID){
-                    ecs::CreatureData Creature = creature_data.vector[other_creature];
+                    // by reference, creatures_thinking writes the brains of the same creatures concurrently
+                    ecs::CreatureData &Creature = world->creature_data.vector[other_creature];
                     if(Creature.state & CreatureData::ALIVE){
                         particle.energy -= creatures_physics_IO::getFeedingRate(Creature, normal, false) * config::SIM_DELTA;
                     }
                 }
-                body.last_collision.other_id = INVALID_CID;
             }
 
             if(particle.energy >= config::PLANT_MAX_ENERGY){
@@ -2,15 +2,20 @@
 #include "systems/physics.hpp"
 #include "ecs.hpp"
 #include "config.hpp"
+#include "util/thread_pool.hpp"
+#include "util/frame_arena.hpp"
 
 #include <cmath>
 
 namespace physics {
 
     static void integratePosition(ecs::PhysicsBody &b);
-    static inline void solveCollisionPair(ecs::CID a, ecs::CID b);
-    static void registerRegionMembers();
+    using Contacts = std::vector<ecs::ContactPair>;
+
+    static inline void solveCollisionPair(ecs::CID a, ecs::CID b, Contacts &contacts);
     static void solveCollisions();
+    static void solveCoarse();
+    static void gatherContacts();
     static void randomizeFlow(uint64 tick);
 
     void initialize(){
@@ -24,15 +29,21 @@ namespace physics {
     void update(uint64 tick){
         registerRegionMembers();
         solveCollisions();
+        solveCoarse();
+        gatherContacts();
 
         // integration
-        for(size_t i = 0; i < ecs::physics_bodies.vector.size(); i++){
-            integratePosition(ecs::physics_bodies.vector[i]);
-        }
+        static constexpr int CHUNK = 1024;
+        int bodies = ecs::world->physics_bodies.vector.size();
+        thread_pool::parallelFor((bodies + CHUNK - 1) / CHUNK, [bodies](int chunk){
+            ecs::PhysicsBody *body = ecs::world->physics_bodies.vector.data();
+            for(int i = chunk * CHUNK; i < MIN((chunk + 1) * CHUNK, bodies); i++){
+                integratePosition(body[i]);
+            }
+        });
 
-        static int counter = 0;
-        counter++;
-        if(counter % config::PHYSICS_MAP_UPDATE_RATE == 0){
+        ecs::world->flow_counter++;
+        if(ecs::world->flow_counter % config::PHYSICS_MAP_UPDATE_RATE == 0){
             randomizeFlow(tick);
         }
     }
@@ -72,9 +83,9 @@ namespace physics {
         b.angular_acceleration = 0.0f;
     }
 
-    static inline void solveCollisionPair(ecs::CID a, ecs::CID b){
-        ecs::PhysicsBody &A = ecs::physics_bodies.vector[a];
-        ecs::PhysicsBody &B = ecs::physics_bodies.vector[b];
+    static inline void solveCollisionPair(ecs::CID a, ecs::CID b, Contacts &contacts){
+        ecs::PhysicsBody &A = ecs::world->physics_bodies.vector[a];
+        ecs::PhysicsBody &B = ecs::world->physics_bodies.vector[b];
 
         vec2 collision_axis = A.position - B.position;
         float dist = glm::length(collision_axis);
@@ -94,10 +105,7 @@ namespace physics {
             A.position += config::PHYSICS_COLLISION_FORCE * B.mass * force;
             B.position -= config::PHYSICS_COLLISION_FORCE * A.mass * force;
 
-            A.last_collision.other_id = b;
-            B.last_collision.other_id = a;
-            A.last_collision.other_vector = -normal;
-            B.last_collision.other_vector = normal;
+            contacts.push_back({a, b, normal});
         }
     }
 
@@ -105,122 +113,480 @@ namespace physics {
 
     /* REGION LOGIC */
 
-    struct Region {
-        std::vector<ecs::CID> members;
-        vec2 flow;
-    };
+    using ecs::Region;
+
+    static inline const ecs::CID* members(const Region &region){
+        return ecs::world->region_members.data() + region.first;
+    }
 
+    // broadphase levels, level 0 are the one unit regions of the world and level l has cells 2^l units wide.
+    // a body is registered in the first level whose cells are at least as wide as its diameter
+    static constexpr int LEVELS = config::PHYSICS_GRID_LEVELS;
+    static_assert((1 << (LEVELS - 1)) >= config::PHYSICS_MAP_WIDTH, "the last level must cover the map with one cell");
+    static_assert(config::PHYSICS_MAX_RADIUS <= 0.5f, "bodies of level 0 must not overlap more than two cells per axis");
+
+    static constexpr int levelWidth(int level){
+        return (config::PHYSICS_MAP_WIDTH + (1 << level) - 1) >> level;
+    }
+
+    // cells of all levels are numbered back to back, this is the number of the first cell of the level
+    static constexpr uint32 levelOffset(int level){
+        uint32 offset = 0;
+        for(int l = 0; l < level; l++){
+            offset += levelWidth(l) * levelWidth(l);
+        }
+        return offset;
+    }
+
+    static constexpr uint32 FINE_CELLS = levelOffset(1);
+    static constexpr uint32 COARSE_CELLS = levelOffset(LEVELS) - FINE_CELLS;
+
+    static inline float levelMaxRadius(int level){
+        return level == 0 ? config::PHYSICS_MAX_RADIUS : 0.5f * (1 << level);
+    }
+
+    static inline int bodyLevel(float radius){
+        int level = 0;
+        while(level < LEVELS - 1 && radius > levelMaxRadius(level)){
+            level++;
+        }
+        return level;
+    }
+
+    static inline Region* levelRegions(int level){
+        return level == 0 ? &ecs::world->regions[0][0] : ecs::world->coarse_regions.data() + levelOffset(level) - FINE_CELLS;
+    }
 
-    static Region regions[config::PHYSICS_MAP_WIDTH][config::PHYSICS_MAP_WIDTH];
-    
     static inline float i2f(uint32 x){
         return 2.0f * (float)x / (float)UINT32_MAX - 1.0f;
     }
 
     static void randomizeFlow(uint64 tick){
-        static int y = 0;
+        int &y = ecs::world->flow_row;
         for(int x = 0; x < config::PHYSICS_MAP_WIDTH; x++){
             uint32 r = hash(tick * 2 * config::PHYSICS_MAP_WIDTH + 2 * x + config::SIM_SEED);
             uint32 r2 = hash(tick * 2 * config::PHYSICS_MAP_WIDTH + 2 * x + config::SIM_SEED + 1);
             
-            regions[y][x].flow = vec2(i2f(r), i2f(r2));
+            ecs::world->regions[y][x].flow = vec2(i2f(r), i2f(r2));
         }
         y = (y + 1) % config::PHYSICS_MAP_WIDTH;
     }
 
-    ecs::CID findBody(vec2 position){
-        int cell_x = (int)position.x;
-        int cell_y = (int)position.y;
+    // calls visit(cid, body) for every body of the level registered with its center within reach of position,
+    // the caller does the exact test. visit returns false to stop early, which is passed on
+    template <class F>
+    static inline bool forEachBodyInLevel(int level, vec2 position, float reach, F &visit){
+        float cell = (float)(1 << level);
+        int width = levelWidth(level);
+        int min_x = MAX((int)((position.x - reach) / cell), 0);
+        int min_y = MAX((int)((position.y - reach) / cell), 0);
+        int max_x = MIN((int)((position.x + reach) / cell), width - 1);
+        int max_y = MIN((int)((position.y + reach) / cell), width - 1);
+
+        const Region *grid = levelRegions(level);
+        const ecs::PhysicsBody *bodies = ecs::world->physics_bodies.vector.data();
+        ecs::CID n = ecs::world->physics_bodies.vector.size();
+        for(int y = min_y; y <= max_y; y++){
+            for(int x = min_x; x <= max_x; x++){
+                const Region &region = grid[y * width + x];
+                const ecs::CID *candidates = members(region);
+                // only bodies homed here, so every body is reported once
+                for(uint32 i = 0; i < region.home; i++){
+                    ecs::CID cid = candidates[i];
+                    if(cid >= n){
+                        // the grid may predate bodies freed this tick
+                        continue;
+                    }
+                    if(!visit(cid, bodies[cid])){
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
 
-        if(cell_x < 0 || cell_y < 0 || cell_x >= config::PHYSICS_MAP_WIDTH || cell_y >= config::PHYSICS_MAP_WIDTH){
-            return ecs::INVALID_CID;
+    // walks all levels holding bodies, with overlap the reach grows by the largest radius of each level
+    template <class F>
+    static inline void forEachBody(vec2 position, float radius, bool overlap, F visit){
+        for(int level = 0; level < LEVELS; level++){
+            if(ecs::world->level_bodies[level] == 0){
+                continue;
+            }
+            float reach = overlap ? radius + levelMaxRadius(level) : radius;
+            if(!forEachBodyInLevel(level, position, reach, visit)){
+                return;
+            }
         }
+    }
 
-        //cout << "findPhysicsBody() in " << cell_x << " " << cell_y << endl;
+    size_t queryPoint(vec2 position, ecs::CID *out, size_t capacity){
+        return queryCircle(position, 0.0f, out, capacity);
+    }
 
-        std::vector<ecs::CID> candidates = regions[cell_y][cell_x].members;
-        for(size_t i = 0; i < candidates.size(); i++){
-            ecs::PhysicsBody &A = ecs::physics_bodies.vector[candidates[i]];
-            vec2 dist = position - A.position;
-            if(dist.x * dist.x + dist.y * dist.y < A.radius * A.radius){
-                return candidates[i];
+    size_t queryCircle(vec2 center, float radius, ecs::CID *out, size_t capacity){
+        size_t found = 0;
+        forEachBody(center, radius, true, [&](ecs::CID cid, const ecs::PhysicsBody &body){
+            float reach = radius + body.radius;
+            if(glm::length2(center - body.position) < reach * reach){
+                if(found < capacity){
+                    out[found] = cid;
+                }
+                found++;
             }
+            return true;
+        });
+        return found;
+    }
+
+    size_t queryNearest(vec2 position, float radius, ecs::CID *out, size_t k){
+        if(k == 0){
+            return 0;
         }
-        return ecs::INVALID_CID;
+        frame_arena::Scope scope;
+        float *distancesSq = frame_arena::allocate<float>(k);
+        size_t found = 0;
+        forEachBody(position, radius, false, [&](ecs::CID cid, const ecs::PhysicsBody &body){
+            float distanceSq = glm::length2(position - body.position);
+            if(distanceSq >= radius * radius || (found == k && distanceSq >= distancesSq[k - 1])){
+                return true;
+            }
+            // insertion into the sorted result, the farthest drops out when full
+            size_t i = found < k ? found++ : k - 1;
+            for(; i > 0 && distancesSq[i - 1] > distanceSq; i--){
+                distancesSq[i] = distancesSq[i - 1];
+                out[i] = out[i - 1];
+            }
+            distancesSq[i] = distanceSq;
+            out[i] = cid;
+            return true;
+        });
+        return found;
     }
 
-    static void registerRegionMembers(){
-        // erase all previous storage
-        for(int y = 0; y < config::PHYSICS_MAP_WIDTH; y++){
-            for(int x = 0; x < config::PHYSICS_MAP_WIDTH; x++){
-                regions[y][x].members.clear();
+    ecs::CID findBody(vec2 position){
+        ecs::CID cid = ecs::INVALID_CID;
+        forEachBody(position, 0.0f, true, [&](ecs::CID candidate, const ecs::PhysicsBody &body){
+            if(glm::length2(position - body.position) < body.radius * body.radius){
+                cid = candidate;
+                return false;
             }
+            return true;
+        });
+        return cid;
+    }
+
+    ecs::CID findNearestBody(vec2 position, float radius, const std::function<bool(ecs::CID)> &accept){
+        ecs::CID best = ecs::INVALID_CID;
+        float best_distanceSq = radius * radius;
+        forEachBody(position, radius, false, [&](ecs::CID cid, const ecs::PhysicsBody &body){
+            float distanceSq = glm::length2(position - body.position);
+            if(distanceSq < best_distanceSq && accept(cid)){
+                best = cid;
+                best_distanceSq = distanceSq;
+            }
+            return true;
+        });
+        return best;
+    }
+
+    // regions of the level overlapped by the body, the own cell and the neighbours on the closer sides
+    static inline int bodyRegions(const ecs::PhysicsBody &body, int level, Region *regions[4]){
+        float cell = (float)(1 << level);
+        int width = levelWidth(level);
+        float grid_x = body.position.x / cell;
+        float grid_y = body.position.y / cell;
+        int cell_x = (int)grid_x;
+        int cell_y = (int)grid_y;
+        float remainder_x = grid_x - cell_x;
+        float remainder_y = grid_y - cell_y;
+        int offset_x = remainder_x < 0.5f ? -1.0f : 1.0f;
+        int offset_y = remainder_y < 0.5f ? -1.0f : 1.0f;
+
+        if(cell_x < 0 || cell_y < 0 || cell_x >= width || cell_y >= width){
+            // outside of collision detection
+            return 0;
         }
 
-        // register new locations
-        int n = ecs::physics_bodies.vector.size();
-        for(int b = 0; b < n; b++){
-            ecs::PhysicsBody &body = ecs::physics_bodies.vector[b];
+        bool valid_x = cell_x + offset_x >= 0 && cell_x + offset_x < width;
+        bool valid_y = cell_y + offset_y >= 0 && cell_y + offset_y < width;
+
+        Region *grid = levelRegions(level);
+        int n = 0;
+        regions[n++] = &grid[cell_y * width + cell_x];
+        if(valid_x){
+            regions[n++] = &grid[cell_y * width + cell_x + offset_x];
+        }
+        if(valid_y){
+            regions[n++] = &grid[(cell_y + offset_y) * width + cell_x];
+        }
+        if(valid_x && valid_y){
+            regions[n++] = &grid[(cell_y + offset_y) * width + cell_x + offset_x];
+        }
+        return n;
+    }
 
-            int cell_x = (int)body.position.x;
-            int cell_y = (int)body.position.y;
-            float remainder_x = body.position.x - cell_x;
-            float remainder_y = body.position.y - cell_y;
-            int offset_x = remainder_x < 0.5f ? -1.0f : 1.0f;
-            int offset_y = remainder_y < 0.5f ? -1.0f : 1.0f;
+    static inline void resetLevel(int level){
+        Region *grid = levelRegions(level);
+        for(int i = 0; i < levelWidth(level) * levelWidth(level); i++){
+            grid[i].count = 0;
+            grid[i].home = 0;
+        }
+    }
 
-            if(cell_x < 0 || cell_y < 0 || cell_x >= config::PHYSICS_MAP_WIDTH || cell_y >= config::PHYSICS_MAP_WIDTH){
-                // outside of collision detection
+    void registerRegionMembers(){
+        // counting sort into one array, its capacity is reserved for four regions per entity so this never allocates.
+        // the overlapped regions of every body are kept in the frame arena between the passes
+        struct Overlap {
+            Region *regions[4];
+            int count;
+        };
+        frame_arena::Scope scope;
+        ecs::World &w = *ecs::world;
+        if(w.coarse_regions.size() != COARSE_CELLS){
+            // once per world, coarse levels stay empty until a body needs them
+            w.coarse_regions.resize(COARSE_CELLS);
+        }
+        resetLevel(0);
+        for(int level = 1; level < LEVELS; level++){
+            if(w.level_bodies[level] > 0){
+                resetLevel(level);
+            }
+        }
+        memset(w.level_bodies, 0, sizeof(w.level_bodies));
+
+        int n = w.physics_bodies.vector.size();
+        Overlap *overlaps = frame_arena::allocate<Overlap>(n);
+        for(int b = 0; b < n; b++){
+            const ecs::PhysicsBody &body = w.physics_bodies.vector[b];
+            int level = bodyLevel(body.radius);
+            Overlap &overlap = overlaps[b];
+            overlap.count = bodyRegions(body, level, overlap.regions);
+            for(int i = 0; i < overlap.count; i++){
+                overlap.regions[i]->count++;
+            }
+            if(overlap.count > 0){
+                overlap.regions[0]->home++;
+                w.level_bodies[level]++;
+            }
+        }
+
+        uint32 total = 0;
+        for(int level = 0; level < LEVELS; level++){
+            if(level > 0 && w.level_bodies[level] == 0){
                 continue;
             }
-         
-            bool valid_x = cell_x + offset_x >= 0 && cell_x + offset_x < config::PHYSICS_MAP_WIDTH;
-            bool valid_y = cell_y + offset_y >= 0 && cell_y + offset_y < config::PHYSICS_MAP_WIDTH;
+            Region *grid = levelRegions(level);
+            for(int i = 0; i < levelWidth(level) * levelWidth(level); i++){
+                grid[i].first = total;
+                total += grid[i].count;
+                grid[i].count = 0;
+            }
+        }
+        w.region_members.resize(total);
 
-            regions[cell_y][cell_x].members.push_back(b);
-            if(valid_x){
-                regions[cell_y][cell_x + offset_x].members.push_back(b);
+        // bodies homed in a region first, then the ones reaching into it, each in ascending order
+        ecs::CID *all = w.region_members.data();
+        for(int b = 0; b < n; b++){
+            if(overlaps[b].count > 0){
+                Region *home = overlaps[b].regions[0];
+                all[home->first + home->count++] = b;
             }
-            if(valid_y){
-                regions[cell_y + offset_y][cell_x].members.push_back(b);
+        }
+        for(int b = 0; b < n; b++){
+            for(int i = 1; i < overlaps[b].count; i++){
+                Region *region = overlaps[b].regions[i];
+                all[region->first + region->count++] = b;
             }
-            if(valid_x && valid_y){
-                regions[cell_y + offset_y][cell_x + offset_x].members.push_back(b);
-            }   
         }
     }
 
-    static void solveCollisions(){
-        for(int y = 0; y < config::PHYSICS_MAP_WIDTH; y++){
+    void solveCollisionPairs(const ecs::CID *pairs, size_t count){
+        static thread_local Contacts contacts;
+        contacts.clear();
+        for(size_t i = 0; i < count; i++){
+            solveCollisionPair(pairs[2 * i], pairs[2 * i + 1], contacts);
+        }
+    }
+
+    static constexpr int STRIPS = (config::PHYSICS_MAP_WIDTH + config::PHYSICS_STRIP_ROWS - 1) / config::PHYSICS_STRIP_ROWS;
+    static_assert(config::PHYSICS_STRIP_ROWS >= 2, "a body spans two rows, strips of one phase must not share bodies");
+
+    static Contacts& stripContacts(int strip){
+        ecs::World &w = *ecs::world;
+        if(w.contact_pairs.size() != STRIPS + 1){
+            // once per world, a crowd may gather in a single strip so each one holds the whole limit
+            w.contact_pairs.resize(STRIPS + 1);
+            for(Contacts &contacts : w.contact_pairs){
+                contacts.reserve(config::PHYSICS_MAX_CONTACTS);
+            }
+        }
+        return w.contact_pairs[strip];
+    }
+
+    // bodies homed in the cell against each other and against the ones homed in the cells right, above left, above
+    // and above right. overlapping bodies of a level have neighbouring home cells, so every pair is solved once
+    static inline void solveCell(const Region *grid, int width, int x, int y, Contacts &contacts){
+        static const int FORWARD[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+        const Region &region = grid[y * width + x];
+        const ecs::CID *home = members(region);
+        for(uint32 i = 0; i < region.home; i++){
+            for(uint32 j = i + 1; j < region.home; j++){
+                solveCollisionPair(home[i], home[j], contacts);
+            }
+        }
+        for(int f = 0; f < 4; f++){
+            int nx = x + FORWARD[f][0];
+            int ny = y + FORWARD[f][1];
+            if(nx < 0 || nx >= width || ny >= width){
+                continue;
+            }
+            const Region &neighbour = grid[ny * width + nx];
+            const ecs::CID *other = members(neighbour);
+            for(uint32 i = 0; i < region.home; i++){
+                for(uint32 j = 0; j < neighbour.home; j++){
+                    solveCollisionPair(home[i], other[j], contacts);
+                }
+            }
+        }
+    }
+
+    static void solveStrip(int strip){
+        const Region *grid = levelRegions(0);
+        Contacts &contacts = stripContacts(strip);
+        contacts.clear();
+        int y_end = MIN((strip + 1) * config::PHYSICS_STRIP_ROWS, config::PHYSICS_MAP_WIDTH);
+        for(int y = strip * config::PHYSICS_STRIP_ROWS; y < y_end; y++){
             for(int x = 0; x < config::PHYSICS_MAP_WIDTH; x++){
-                std::vector<ecs::CID> &candidates = regions[y][x].members;
-                int n = candidates.size();
+                const Region &region = ecs::world->regions[y][x];
+                const ecs::CID *home = members(region);
+
+                // small brownian acceleration, once per body from its home cell
+                for(uint32 i = 0; i < region.home; i++){
+                    ecs::PhysicsBody &A = ecs::world->physics_bodies.vector[home[i]];
+                    A.force += config::PHYSICS_MAP_BROWNIAN_FORCE * region.flow;
+                    A.torque_force += config::PHYSICS_MAP_BROWNIAN_TORQUE * region.flow.x;
+                }
+
+                solveCell(grid, config::PHYSICS_MAP_WIDTH, x, y, contacts);
+            }
+        }
+    }
+
+    static void solveCollisions(){
+        // sized here, the strips must not resize the buffers of each other
+        stripContacts(0);
+
+        // region rows are split into strips, a strip touches the bodies homed in its rows and the row above
+        // so it can only share them with neighbouring strips. even strips run in parallel first, then odd ones,
+        // the result does not depend on the thread count
+        for(int parity = 0; parity < 2; parity++){
+            thread_pool::parallelFor((STRIPS + 1 - parity) / 2, [parity](int i){
+                solveStrip(2 * i + parity);
+            });
+        }
+    }
+
+    // a body above level 0 against the bodies of the finer levels, plus the brownian flow of the unit cell at its center
+    static void solveAgainstFiner(ecs::CID cid, int level, Contacts &contacts){
+        ecs::PhysicsBody &body = ecs::world->physics_bodies.vector[cid];
+        int cell_x = (int)body.position.x;
+        int cell_y = (int)body.position.y;
+        if(cell_x >= 0 && cell_y >= 0 && cell_x < config::PHYSICS_MAP_WIDTH && cell_y < config::PHYSICS_MAP_WIDTH){
+            body.force += config::PHYSICS_MAP_BROWNIAN_FORCE * ecs::world->regions[cell_y][cell_x].flow;
+            body.torque_force += config::PHYSICS_MAP_BROWNIAN_TORQUE * ecs::world->regions[cell_y][cell_x].flow.x;
+        }
 
-                for(int i = 0; i < n; i++){
-                    // small brownian acceleration
-                    ecs::PhysicsBody &A = ecs::physics_bodies.vector[candidates[i]];
-                    A.force += config::PHYSICS_MAP_BROWNIAN_FORCE * regions[y][x].flow;
-                    A.torque_force += config::PHYSICS_MAP_BROWNIAN_TORQUE * regions[y][x].flow.x;
+        auto visit = [cid, &contacts](ecs::CID other, const ecs::PhysicsBody&){
+            solveCollisionPair(cid, other, contacts);
+            return true;
+        };
+        for(int finer = 0; finer < level; finer++){
+            if(ecs::world->level_bodies[finer] > 0){
+                forEachBodyInLevel(finer, body.position, body.radius + levelMaxRadius(finer), visit);
+            }
+        }
+    }
 
-                    for(int j = i+1; j < n; j++){
-                        solveCollisionPair(candidates[i], candidates[j]);
+    static void solveCoarse(){
+        // bodies larger than PHYSICS_MAX_RADIUS are rare, their levels are solved on the calling thread after the strips
+        Contacts &contacts = stripContacts(STRIPS);
+        contacts.clear();
+        for(int level = 1; level < LEVELS; level++){
+            if(ecs::world->level_bodies[level] == 0){
+                continue;
+            }
+            const Region *grid = levelRegions(level);
+            int width = levelWidth(level);
+            for(int y = 0; y < width; y++){
+                for(int x = 0; x < width; x++){
+                    solveCell(grid, width, x, y, contacts);
+                    const Region &region = grid[y * width + x];
+                    const ecs::CID *home = members(region);
+                    for(uint32 i = 0; i < region.home; i++){
+                        solveAgainstFiner(home[i], level, contacts);
                     }
                 }
             }
         }
     }
 
+    static void gatherContacts(){
+        // the strips recorded their pairs independently, this sorts them by body into one array in strip order
+        ecs::World &w = *ecs::world;
+        int n = w.physics_bodies.vector.size();
+        w.contact_first.assign(n + 1, 0);
+        uint32 *first = w.contact_first.data();
+        for(const Contacts &pairs : w.contact_pairs){
+            for(const ecs::ContactPair &pair : pairs){
+                first[pair.a]++;
+                first[pair.b]++;
+            }
+        }
+
+        uint32 total = 0;
+        for(int b = 0; b <= n; b++){
+            uint32 count = first[b];
+            first[b] = total;
+            total += count;
+        }
+        w.contacts.resize(total);
+
+        // first[b] runs up to the start of b + 1 while filling and is shifted back afterwards
+        ecs::CollisionInfo *contacts = w.contacts.data();
+        for(const Contacts &pairs : w.contact_pairs){
+            for(const ecs::ContactPair &pair : pairs){
+                contacts[first[pair.a]++] = {pair.b, -pair.normal};
+                contacts[first[pair.b]++] = {pair.a, pair.normal};
+            }
+        }
+        for(int b = n; b > 0; b--){
+            first[b] = first[b - 1];
+        }
+        first[0] = 0;
+    }
+
+    ContactRange getContacts(ecs::CID body){
+        if(body + 1 >= ecs::world->contact_first.size()){
+            return {nullptr, nullptr};
+        }
+        const ecs::CollisionInfo *contacts = ecs::world->contacts.data();
+        return {contacts + ecs::world->contact_first[body], contacts + ecs::world->contact_first[body + 1]};
+    }
+
     
 
 
 
 
 
-    static void raycast_cell(RaycastInfo &info, Region &region, vec2 normal, vec2 start_position){
+    static void raycast_cell(RaycastInfo &info, const Region &region, vec2 normal, vec2 start_position){
        float min = (float)1e20;
-       for(int i = 0; i < (int)region.members.size(); i++){
+       const ecs::CID *candidates = members(region);
+       for(int i = 0; i < (int)region.count; i++){
 
-            ecs::PhysicsBody &target = ecs::physics_bodies.vector[region.members[i]];
+            ecs::PhysicsBody &target = ecs::world->physics_bodies.vector[candidates[i]];
             vec2 to_target = target.position - start_position;
             float ray_scale = glm::dot(normal, to_target);
             if(ray_scale <= 0.0f){
@@ -233,7 +599,7 @@ namespace physics {
             if(glm::length2(in_circle) < target.radius * target.radius){
                 float len = glm::length2(to_target);
                 if(len < min){
-                    info.hit_id = region.members[i];
+                    info.hit_id = candidates[i];
                     info.distanceSq = glm::length2(to_target);
                     min = len;
                 }
@@ -243,8 +609,11 @@ namespace physics {
 
    
 
-    RaycastInfo raycast(vec2 position, vec2 normal, float range){
+    static RaycastInfo raycastLevel(int level, vec2 position, vec2 normal, float range){
 
+        float cell = (float)(1 << level);
+        int width = levelWidth(level);
+        const Region *grid = levelRegions(level);
         vec2 start_position = position;
         float distanceSq = 0.0f;
         RaycastInfo info;
@@ -259,14 +628,14 @@ namespace physics {
 
         while(distanceSq < range * range){
             
-            int cell_x = (int)position.x;
-            int cell_y = (int)position.y;
+            int cell_x = (int)(position.x / cell);
+            int cell_y = (int)(position.y / cell);
 
-            if(cell_x < 0 || cell_y < 0 || cell_x >= config::PHYSICS_MAP_WIDTH || cell_y >= config::PHYSICS_MAP_WIDTH){
+            if(cell_x < 0 || cell_y < 0 || cell_x >= width || cell_y >= width){
                 break;
             }
 
-            raycast_cell(info, regions[cell_y][cell_x], normal, start_position);
+            raycast_cell(info, grid[cell_y * width + cell_x], normal, start_position);
 
             if(info.hit_id != ecs::INVALID_CID){
                 info.distanceSq = std::min(range * range, info.distanceSq);
@@ -276,15 +645,15 @@ namespace physics {
             int next_cell_x = cell_x + step_x;
             int next_cell_y = cell_y + step_y;
 
-            float scale_x = abs((next_cell_x - position.x) * ndx);
-            float scale_y = abs((next_cell_y - position.y) * ndy);
+            float scale_x = abs((next_cell_x * cell - position.x) * ndx);
+            float scale_y = abs((next_cell_y * cell - position.y) * ndy);
             
             if(scale_x < scale_y){
-                position.x = (float)next_cell_x;
+                position.x = next_cell_x * cell;
                 position.y = position.y + scale_x * normal.y;
             }else{
                 position.x = position.x + scale_y * normal.x;
-                position.y = (float)next_cell_y;
+                position.y = next_cell_y * cell;
             }
             distanceSq = glm::length2(position - start_position);
         }
@@ -293,5 +662,19 @@ namespace physics {
         info.distanceSq = range * range;
         return info;
     }
+
+    RaycastInfo raycast(vec2 position, vec2 normal, float range){
+        RaycastInfo info = raycastLevel(0, position, normal, range);
+        for(int level = 1; level < LEVELS; level++){
+            if(ecs::world->level_bodies[level] == 0){
+                continue;
+            }
+            RaycastInfo coarse = raycastLevel(level, position, normal, range);
+            if(coarse.hit_id != ecs::INVALID_CID && coarse.distanceSq < info.distanceSq){
+                info = coarse;
+            }
+        }
+        return info;
+    }
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 #include "engine/common.hpp"
 #include "ecs.hpp"
+#include <functional>
 
 namespace physics {
 
@@ -12,13 +13,48 @@ namespace physics {
 
     // ================== read only =============
 
+    // spatial queries run on the grid of the last update and report every body once
+    // up to capacity body cids are written to out, the return value is the number of matches and may be larger
+
+    // bodies containing the point
+    size_t queryPoint(vec2 position, ecs::CID *out, size_t capacity);
+
+    // bodies overlapping the circle
+    size_t queryCircle(vec2 center, float radius, ecs::CID *out, size_t capacity);
+
+    // up to k bodies with their center within radius, nearest first, returns how many were written
+    size_t queryNearest(vec2 position, float radius, ecs::CID *out, size_t k);
+
+    // any body containing the point
     ecs::CID findBody(vec2 position);
 
+    // nearest body center within radius for which accept(cid) holds, accept is only asked for bodies closer than the best so far
+    ecs::CID findNearestBody(vec2 position, float radius, const std::function<bool(ecs::CID)> &accept);
+
+    struct ContactRange {
+        const ecs::CollisionInfo *first;
+        const ecs::CollisionInfo *last;
+
+        const ecs::CollisionInfo* begin() const { return first; }
+        const ecs::CollisionInfo* end() const { return last; }
+        bool empty() const { return first == last; }
+    };
+
+    // every body touching the body at the last update, empty for bodies added since
+    ContactRange getContacts(ecs::CID body);
+
     struct RaycastInfo {
         ecs::CID hit_id = ecs::INVALID_CID;
         float distanceSq = 0.0f;
     };
 
     RaycastInfo raycast(vec2 position, vec2 normal, float range);
+
+    // ================== exposed for benchmarks =============
+
+    void registerRegionMembers();
+
+    // pairs are laid out as a0, b0, a1, b1, ...
+    void solveCollisionPairs(const ecs::CID *pairs, size_t count);
 }
  
@@ -9,73 +9,113 @@
 #include "util/mesher_primitive.hpp"
 #include "util/debuglines.hpp"
 #include "util/gui.hpp"
+#include "util/capture.hpp"
+#include "util/species.hpp"
 #include "environment.hpp"
+#include "heatmap.hpp"
+#include "engine/texture.hpp"
 
 
 namespace rendering {
 
     static Mesh circle;
+    static Mesh world_quad;
     static Shader default_shader;
     static Shader default_instance_shader;
+    static Shader texture_shader;
+    static Texture heatmap_texture;
 
     static int UI_state = 0;
     static string UI_sim_state_info = "-";
     static vec3 cam_position = vec3(config::CAM_X, config::CAM_Y, config::CAM_Z);
     static vec3 cam_velocity = vec3(0.0f, 0.0f, 0.0f);
     static vec3 cam_input_vector = vec3(0.0f, 0.0f, 0.0f);
+    static int screen_width = config::RENDER_RESOLUTION_X;
+    static int screen_height = config::RENDER_RESOLUTION_Y;
 
     static void drawGui(ecs::CID UI_source);
     static void drawEntities();
+    static void drawHeatmap();
     static void updateCamera(float dt, ecs::CID follow_target);
 
     void initialize(){
         engine::createGLWindow(config::SIM_NAME, config::RENDER_RESOLUTION_X, config::RENDER_RESOLUTION_Y, config::RENDER_RESIZABLE, 3, 3);
         debuglines::initialize();
         gui::initialize();
+        capture::initialize();
 
         resize(config::RENDER_RESOLUTION_X, config::RENDER_RESOLUTION_Y);   // fixviewport
         camera::setProjection(100.0f, 0.1f, 200.0f);
         camera::setPosition(cam_position);
         default_shader.compile(string("resources/color.vert"), string("resources/color.frag"));
         default_instance_shader.compile(string("resources/color_instance.vert"), string("resources/color.frag"));
+        texture_shader.compile(string("resources/texture.vert"), string("resources/texture.frag"));
+        texture_shader.setUniformInteger(1, 0);
     
         // create circle mesh
         Mesh::VertexBuffer vb;
         Mesh::IndexBuffer ib;
         mesher_primitive::circle(circle.vertex_buffer, circle.index_buffer, vec3(), vec2(1.0f), COLOR_GREEN, 32);
         circle.upload(Mesh::STATIC, true);
+
+        // heatmap covers the whole region grid
+        const float w = config::PHYSICS_MAP_WIDTH;
+        mesher_primitive::quad(world_quad.vertex_buffer, world_quad.index_buffer, vec3(0.0f), vec2(w, w), vec2(0.0f), vec2(1.0f), COLOR_WHITE);
+        world_quad.upload(Mesh::STATIC, false);
+        heatmap_texture.create(config::PHYSICS_MAP_WIDTH, config::PHYSICS_MAP_WIDTH);
     }
 
     void cleanup(){
         default_shader.destroy();
         default_instance_shader.destroy();
+        texture_shader.destroy();
+        heatmap_texture.destroy();
+        world_quad.destroy();
+        circle.destroy();
     
         debuglines::cleanup();
         gui::cleanup();
+        capture::cleanup();
     }
 
-    void update(float real_delta){
+    void update(float real_delta, uint64 tick){
         ecs::CID follow_target = ecs::INVALID_CID;
         ecs::CID UI_source = ecs::INVALID_CID;
-        for(ecs::CID cid = 0; cid < ecs::creature_data.vector.size(); cid++){
-            if(ecs::creature_data.vector[cid].highlighted){
+        for(ecs::CID cid = 0; cid < ecs::world->creature_data.vector.size(); cid++){
+            if(ecs::world->creature_data.vector[cid].highlighted){
                 follow_target = cid;
             }
-            if(ecs::creature_data.vector[cid].ui_source){
+            if(ecs::world->creature_data.vector[cid].ui_source){
                 UI_source = cid;
             }
         }
 
         updateCamera(real_delta, follow_target);
 
+        capture::update();
+        if(capture::isDue(tick)){
+            capture::beginFrame();
+            camera::setScreenSize(capture::getWidth(), capture::getHeight());
+            engine::clearScreen(0.5, 0.5, 0.5);
+            drawEntities();
+            capture::endFrame();
+            camera::setScreenSize(screen_width, screen_height);
+        }
+
         engine::clearScreen(0.5, 0.5, 0.5);
-        drawEntities();
+        if(heatmap::getMode() != heatmap::NONE){
+            drawHeatmap();
+        }else{
+            drawEntities();
+        }
         debuglines::render(camera::getProjectionMatrix() * camera::getViewMatrix(), 4.0f);
         drawGui(UI_source);
         engine::swapBuffer();
     }
 
     void resize(int x, int y){
+        screen_width = x;
+        screen_height = y;
         camera::setScreenSize(x, y);
         engine::setViewport(0, 0, x, y);
     }
@@ -99,8 +139,8 @@ namespace rendering {
 
         if(follow_target != ecs::INVALID_CID){
             // lerp to target
-            ecs::CID body_cid = ecs::physics_bodies.cid_map[ecs::creature_data.id_map[follow_target]];
-            vec2 target_pos = ecs::physics_bodies.vector[body_cid].position;
+            ecs::CID body_cid = ecs::world->physics_bodies.cid_map[ecs::world->creature_data.id_map[follow_target]];
+            vec2 target_pos = ecs::world->physics_bodies.vector[body_cid].position;
             old_pos = glm::mix(old_pos, target_pos, config::CAM_LERP * dt);
             cam_position = vec3(old_pos.x, old_pos.y, cam_position.z);
             cam_velocity = vec3(0.0f, 0.0f, cam_velocity.z);
@@ -133,20 +173,31 @@ namespace rendering {
     }
 
 
+    // conservative test of a world space circle against the clip volume
+    static bool isVisible(const mat4 &view_projection, vec2 position, float radius){
+        vec4 clip = view_projection * vec4(position.x, position.y, 0.0f, 1.0f);
+        float margin_x = radius * (fabsf(view_projection[0][0]) + fabsf(view_projection[1][0]));
+        float margin_y = radius * (fabsf(view_projection[0][1]) + fabsf(view_projection[1][1]));
+        float margin_w = radius * (fabsf(view_projection[0][3]) + fabsf(view_projection[1][3]));
+        return fabsf(clip.x) <= clip.w + margin_x + margin_w && fabsf(clip.y) <= clip.w + margin_y + margin_w;
+    }
+
     static void drawEntities(){
         default_shader.load();
 
         mat4 view_projection = camera::getProjectionMatrix() * camera::getViewMatrix();
-        std::vector<float> instance_data;
+        // kept between frames so the buffer only grows when the plant count does
+        static std::vector<float> instance_data;
+        instance_data.clear();
 
-        for(ecs::CID cid = 0; cid < ecs::particle_data.vector.size(); cid++){
+        for(ecs::CID cid = 0; cid < ecs::world->particle_data.vector.size(); cid++){
              
-            ecs::PhysicsBody &body = ecs::physics_bodies.vector[ecs::physics_bodies.cid_map[ecs::particle_data.id_map[cid]]];
+            ecs::PhysicsBody &body = ecs::world->physics_bodies.vector[ecs::world->physics_bodies.cid_map[ecs::world->particle_data.id_map[cid]]];
 
             vec2 pos = body.position;
             //float angle = body.theta;
             float radius = body.radius;
-            vec3 color = ecs::particle_data.vector[cid].color;
+            vec3 color = ecs::world->particle_data.vector[cid].color;
 
             instance_data.push_back(pos.x);
             instance_data.push_back(pos.y);
@@ -156,27 +207,35 @@ namespace rendering {
             instance_data.push_back(color[2]);
         }
 
-        for(ecs::CID cid = 0; cid < ecs::creature_data.vector.size(); cid++){
-            if(!(ecs::creature_data.vector[cid].state & ecs::CreatureData::ALIVE)){
+        for(ecs::CID cid = 0; cid < ecs::world->creature_data.vector.size(); cid++){
+            if(!(ecs::world->creature_data.vector[cid].state & ecs::CreatureData::ALIVE)){
                 continue;
             }
-            ecs::PhysicsBody &body = ecs::physics_bodies.vector[ecs::physics_bodies.cid_map[ecs::creature_data.id_map[cid]]];
+            ecs::PhysicsBody &body = ecs::world->physics_bodies.vector[ecs::world->physics_bodies.cid_map[ecs::world->creature_data.id_map[cid]]];
 
             vec2 pos = body.position;
             float angle = body.theta;
             float radius = body.radius;
             //vec3 color = body.color;
 
+            // gpu buffers are only created and updated for creatures in view, appendages reach past the radius
+            if(!isVisible(view_projection, pos, radius * 2.0f)){
+                continue;
+            }
+            Mesh &mesh = ecs::world->meshes[ecs::world->creature_data.vector[cid].mesh_id];
+            if(mesh.vertex_buffer.size() > 0){
+                mesh.upload(Mesh::STATIC, false);
+            }
+            if(mesh.vao == 0){
+                continue;
+            }
+
             mat4 model_matrix = mat4(1.0f);
             model_matrix = glm::translate(model_matrix, vec3(pos.x, pos.y, 0.0f));
             model_matrix = glm::rotate(model_matrix, -angle, vec3(0.0f, 0.0f, -1.0f));
             model_matrix = glm::scale(model_matrix, vec3(radius, radius, radius));
             mat4 MVP = view_projection * model_matrix;
             default_shader.setUniformMat4(0, MVP);
-            Mesh &mesh = ecs::meshes[ecs::creature_data.vector[cid].mesh_id];
-            if(mesh.vertex_buffer.size() > 0){
-                mesh.upload(Mesh::STATIC, false);
-            }
             mesh.draw();
         }
 
@@ -189,104 +248,121 @@ namespace rendering {
 
     }
 
+    static void drawHeatmap(){
+        int pitch;
+        ubyte *pixels = heatmap_texture.get_pixels(pitch);
+        heatmap::colorize(pixels, pitch);
+        heatmap_texture.upload(false);
+
+        texture_shader.load();
+        heatmap_texture.load();
+        texture_shader.setUniformMat4(0, camera::getProjectionMatrix() * camera::getViewMatrix());
+        world_quad.draw();
+    }
+
+    static constexpr int GUI_MAX_ROWS = config::CREATURE_DNA_SIZE / 8;
+    static gui::Text gui_title;
+    static gui::Text gui_labels[GUI_MAX_ROWS];
+    static gui::Text gui_values[GUI_MAX_ROWS];
+
     static void drawGui(ecs::CID UI_source){
         assert(UI_state >= 0 && UI_state <= 4);
-        string section_names[4] = {"Stats", "Genetics", "Physics", "Environment"};
-        
-        
-        std::vector<string> stats;
+        static const char *section_names[4] = {"Stats", "Genetics", "Physics", "Environment"};
+
+        int rows = 0;
 
         if(UI_state == 1 && UI_source != ecs::INVALID_CID){
 
-            ecs::CreatureData &creature = ecs::creature_data.vector[UI_source];
-            stats = {
-                "name",
-                creature.name,
-                "generation",
-                to_string(creature.generations),
-                "mutations",
-                to_string(creature.mutations),
-                "energy",
-                f_to_str(creature.energy),
-                "neurons firing",
-                to_string(creature.number_neurons_firing),
-                "state",
-                to_string(creature.state),
-                "body sides",
-                to_string(creature.appendage_count),
-                "size",
-                f_to_str(creature.size),
-                "metabolic rate",
-                f_to_str(creature.metabolic_rate),
-                "input rate",
-                f_to_str(creature.brain_input_rate),
-                "leak rate",
-                f_to_str(creature.brain_leak_rate),
-                "carnivore",
-                f_to_str(creature.carnivore),
-                "sex",
-                f_to_str(creature.sex),
-                "mutation rate",
-                f_to_str(creature.mutation_rate),
-            };
+            ecs::CreatureData &creature = ecs::world->creature_data.vector[UI_source];
+            gui::setText(gui_labels[0], "name");
+            gui::setText(gui_values[0], creature.name.c_str());
+            gui::setText(gui_labels[1], "generation");
+            gui::setInt(gui_values[1], creature.generations);
+            gui::setText(gui_labels[2], "mutations");
+            gui::setInt(gui_values[2], creature.mutations);
+            gui::setText(gui_labels[3], "energy");
+            gui::setFloat(gui_values[3], creature.energy);
+            gui::setText(gui_labels[4], "neurons firing");
+            gui::setInt(gui_values[4], creature.number_neurons_firing);
+            gui::setText(gui_labels[5], "state");
+            gui::setInt(gui_values[5], creature.state);
+            gui::setText(gui_labels[6], "body sides");
+            gui::setInt(gui_values[6], creature.appendage_count);
+            gui::setText(gui_labels[7], "size");
+            gui::setFloat(gui_values[7], creature.size);
+            gui::setText(gui_labels[8], "metabolic rate");
+            gui::setFloat(gui_values[8], creature.metabolic_rate);
+            gui::setText(gui_labels[9], "input rate");
+            gui::setFloat(gui_values[9], creature.brain_input_rate);
+            gui::setText(gui_labels[10], "leak rate");
+            gui::setFloat(gui_values[10], creature.brain_leak_rate);
+            gui::setText(gui_labels[11], "carnivore");
+            gui::setFloat(gui_values[11], creature.carnivore);
+            gui::setText(gui_labels[12], "sex");
+            gui::setFloat(gui_values[12], creature.sex);
+            gui::setText(gui_labels[13], "mutation rate");
+            gui::setFloat(gui_values[13], creature.mutation_rate);
+            gui::setText(gui_labels[14], "species");
+            gui::setInt(gui_values[14], species::getSpecies(creature.lineage));
+            rows = 15;
         }
 
         if(UI_state == 2 && UI_source != ecs::INVALID_CID){
-            ecs::CID cid = UI_source;
+            ecs::CreatureData &creature = ecs::world->creature_data.vector[UI_source];
 
-            
-            ecs::CreatureData &creature = ecs::creature_data.vector[cid];
-            string DNA_string = hex_to_str(creature.dna, config::CREATURE_DNA_SIZE);
-
-
-            stats = {};
+            // 8 bytes per row, split in two columns of 4
             for(int i = 0; i < config::CREATURE_DNA_SIZE / 8; i++){
-                stats.push_back(DNA_string.substr(i * 16, 8));
-                stats.push_back(DNA_string.substr(8 + i * 16, 8));
+                gui::setHex(gui_labels[i], &creature.dna[i * 8], 4);
+                gui::setHex(gui_values[i], &creature.dna[i * 8 + 4], 4);
             }
+            rows = config::CREATURE_DNA_SIZE / 8;
         }
 
         if(UI_state == 3 && UI_source != ecs::INVALID_CID){
             ecs::CID cid = UI_source;
-            ecs::ID id = ecs::creature_data.id_map[cid];
+            ecs::ID id = ecs::world->creature_data.id_map[cid];
 			if (id != ecs::INVALID_ID) {
-				cid = ecs::physics_bodies.cid_map[id];
+				cid = ecs::world->physics_bodies.cid_map[id];
 				if (cid != ecs::INVALID_CID) {
-					ecs::PhysicsBody& body = ecs::physics_bodies.vector[cid];
-					stats = {
-						"radius",
-						f_to_str(body.radius),
-						"mass",
-						f_to_str(body.mass)
-					};
+					ecs::PhysicsBody& body = ecs::world->physics_bodies.vector[cid];
+                    gui::setText(gui_labels[0], "radius");
+                    gui::setFloat(gui_values[0], body.radius);
+                    gui::setText(gui_labels[1], "mass");
+                    gui::setFloat(gui_values[1], body.mass);
+                    rows = 2;
 				}
 			}
             
         }
 
         if(UI_state == 4){
-            stats = {
-                "n creatures",
-                to_string(ecs::cellsAlive),
-                "n entities",
-                to_string(ecs::entitiesAlive),
-                "n plant target",
-                to_string((int)environment::getGrowthRate()),
-                "fast forward",
-                UI_sim_state_info
-            };
+            gui::setText(gui_labels[0], "n creatures");
+            gui::setInt(gui_values[0], ecs::world->cellsAlive);
+            gui::setText(gui_labels[1], "n entities");
+            gui::setInt(gui_values[1], ecs::world->entitiesAlive);
+            gui::setText(gui_labels[2], "n plant target");
+            gui::setInt(gui_values[2], (int)environment::getGrowthRate());
+            gui::setText(gui_labels[3], "speed");
+            gui::setText(gui_values[3], UI_sim_state_info.c_str());
+            gui::setText(gui_labels[4], "n species");
+            gui::setInt(gui_values[4], species::getSpeciesCount());
+            rows = 5;
         }
 
         if(UI_state > 0){
-            float boxHeight = 0.05 + stats.size() / 2 * 0.023;
+            float boxHeight = 0.05 + rows * 0.023;
             float box_x = 0.6f;
             float box_width = 0.38f;
             gui::drawBox(box_x + 0.0f, 1.0f - 0.02f - boxHeight, box_width, boxHeight, COLOR_DARKGRAY);
-            gui::drawStringUnscaled(section_names[UI_state-1], box_x + 0.05f, 0.96, 0.04, COLOR_WHITE);
-
-            for(size_t i = 0; i < stats.size() / 2; i++){
-                gui::drawStringUnscaled(stats[i * 2 + 0], box_x + 0.02f, 0.92 - i * 0.023, 0.03, COLOR_WHITE);
-                gui::drawStringUnscaled(stats[i * 2 + 1], box_x + 0.17f, 0.92 - i * 0.023, 0.03, COLOR_WHITE);
+            gui::setText(gui_title, section_names[UI_state-1]);
+            gui::placeText(gui_title, box_x + 0.05f, 0.96, 0.04, COLOR_WHITE);
+            gui::drawText(gui_title);
+
+            for(int i = 0; i < rows; i++){
+                gui::placeText(gui_labels[i], box_x + 0.02f, 0.92 - i * 0.023, 0.03, COLOR_WHITE);
+                gui::placeText(gui_values[i], box_x + 0.17f, 0.92 - i * 0.023, 0.03, COLOR_WHITE);
+                gui::drawText(gui_labels[i]);
+                gui::drawText(gui_values[i]);
             }
         }
         gui::render();
@@ -9,7 +9,7 @@ namespace rendering {
 
     void cleanup();
 
-    void update(float real_delta);
+    void update(float real_delta, uint64 tick);
 
     void moveCamera(vec3 direction);
 
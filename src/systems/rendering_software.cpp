@@ -0,0 +1,286 @@
+#include "systems/rendering_software.hpp"
+#include "engine/common.hpp"
+#include "engine/mesh.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "util/mesher_primitive.hpp"
+#include "util/debuglines.hpp"
+#include "util/files.hpp"
+#include <thread>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2
+#endif
+
+namespace rendering_software {
+
+    static constexpr int SIZE = config::RENDER_SOFTWARE_RESOLUTION;
+    static constexpr int STRIDE = (SIZE + 7) & ~3;        // padding so 4 wide stores never leave the row
+    static constexpr float LINE_WIDTH = 2.0f;
+
+    struct Triangle {
+        vec2 v[3];
+        vec3 color[3];
+    };
+
+    static Mesh::VertexBuffer circle_vertices;
+    static Mesh::IndexBuffer circle_indices;
+    static std::vector<Triangle> triangles;
+    static std::vector<uint32> framebuffer;
+    static std::vector<ubyte> image;
+
+    static float world_to_pixel = 1.0f;
+
+    static void drawEntities();
+    static void drawLines();
+    static void rasterize(int row_begin, int row_end);
+    static void writeImage(uint64 tick);
+
+    void initialize(){
+        mesher_primitive::circle(circle_vertices, circle_indices, vec3(), vec2(1.0f), COLOR_GREEN, config::RENDER_CIRCLE_SEGMENTS);
+        framebuffer.resize(STRIDE * SIZE + 4);
+        image.resize(SIZE * SIZE * 4);
+        world_to_pixel = (float)SIZE / (float)config::PHYSICS_MAP_WIDTH;
+        files::makeDirectory(config::RENDER_SOFTWARE_DIRECTORY);
+    }
+
+    void cleanup(){
+
+    }
+
+    void update(float real_delta, uint64 tick){
+        if(tick % config::RENDER_SOFTWARE_INTERVAL != 0){
+            return;
+        }
+        render();
+        writeImage(tick);
+    }
+
+    const ubyte* render(){
+        triangles.clear();
+        drawEntities();
+        drawLines();
+
+        // clear to the same gray as the gl path
+        const uint32 background = 0xFF808080;
+        std::fill(framebuffer.begin(), framebuffer.end(), background);
+
+        // each thread owns a horizontal band, triangles keep their draw order
+        int thread_count = CLAMP((int)std::thread::hardware_concurrency(), 1, 64);
+        int band = (SIZE + thread_count - 1) / thread_count;
+        std::vector<std::thread> threads;
+        for(int t = 1; t < thread_count; t++){
+            threads.emplace_back(rasterize, MIN(t * band, SIZE), MIN((t + 1) * band, SIZE));
+        }
+        rasterize(0, MIN(band, SIZE));
+        for(std::thread &thread : threads){
+            thread.join();
+        }
+
+        for(int y = 0; y < SIZE; y++){
+            memcpy(&image[y * SIZE * 4], &framebuffer[y * STRIDE], SIZE * 4);
+        }
+        return image.data();
+    }
+
+    /* TRIANGLE SETUP */
+
+    static inline vec2 toPixel(vec2 position){
+        // image rows are top down
+        return vec2(position.x * world_to_pixel, (config::PHYSICS_MAP_WIDTH - position.y) * world_to_pixel);
+    }
+
+    static void addMesh(const Mesh::VertexBuffer &vertices, const Mesh::IndexBuffer &indices, vec2 position, float angle, float scale, const vec3 *instance_color){
+        float c = cosf(angle);
+        float s = sinf(angle);
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            Triangle t;
+            for(int k = 0; k < 3; k++){
+                const Mesh::Vertex &v = vertices[indices[i + k]];
+                vec2 local = vec2(v.position.x * c - v.position.y * s, v.position.x * s + v.position.y * c);
+                t.v[k] = toPixel(position + local * scale);
+                t.color[k] = instance_color != nullptr ? *instance_color : v.color;
+            }
+            triangles.push_back(t);
+        }
+    }
+
+    static void drawEntities(){
+        // same order as the gl path, particles first then creatures on top
+        for(ecs::CID cid = 0; cid < ecs::world->particle_data.vector.size(); cid++){
+            ecs::PhysicsBody &body = ecs::world->physics_bodies.vector[ecs::world->physics_bodies.cid_map[ecs::world->particle_data.id_map[cid]]];
+            addMesh(circle_vertices, circle_indices, body.position, 0.0f, body.radius, &ecs::world->particle_data.vector[cid].color);
+        }
+
+        for(ecs::CID cid = 0; cid < ecs::world->creature_data.vector.size(); cid++){
+            if(!(ecs::world->creature_data.vector[cid].state & ecs::CreatureData::ALIVE)){
+                continue;
+            }
+            ecs::PhysicsBody &body = ecs::world->physics_bodies.vector[ecs::world->physics_bodies.cid_map[ecs::world->creature_data.id_map[cid]]];
+            Mesh &mesh = ecs::world->meshes[ecs::world->creature_data.vector[cid].mesh_id];
+            addMesh(mesh.vertex_buffer, mesh.index_buffer, body.position, body.theta, body.radius, nullptr);
+        }
+    }
+
+    static void drawLines(){
+        Mesh::VertexBuffer &points = debuglines::getPoints();
+        for(size_t i = 0; i + 1 < points.size(); i += 2){
+            vec2 a = toPixel(vec2(points[i].position.x, points[i].position.y));
+            vec2 b = toPixel(vec2(points[i + 1].position.x, points[i + 1].position.y));
+            vec2 d = b - a;
+            float len = glm::length(d);
+            if(len == 0.0f){
+                continue;
+            }
+            vec2 n = vec2(-d.y, d.x) * (0.5f * LINE_WIDTH / len);
+            vec3 ca = points[i].color;
+            vec3 cb = points[i + 1].color;
+            triangles.push_back({{a - n, a + n, b + n}, {ca, ca, cb}});
+            triangles.push_back({{a - n, b + n, b - n}, {ca, cb, cb}});
+        }
+        points.clear();
+    }
+
+    /* RASTERIZATION */
+
+#ifndef RASTER_SSE2
+    static inline uint32 packColor(float r, float g, float b){
+        uint32 ir = (uint32)(255.0f * CLAMP(r, 0.0f, 1.0f));
+        uint32 ig = (uint32)(255.0f * CLAMP(g, 0.0f, 1.0f));
+        uint32 ib = (uint32)(255.0f * CLAMP(b, 0.0f, 1.0f));
+        return ir | (ig << 8) | (ib << 16) | 0xFF000000;
+    }
+#endif
+
+    static void rasterizeTriangle(const Triangle &tri, int row_begin, int row_end){
+        vec2 p0 = tri.v[0];
+        vec2 p1 = tri.v[1];
+        vec2 p2 = tri.v[2];
+        vec3 c0 = tri.color[0];
+        vec3 c1 = tri.color[1];
+        vec3 c2 = tri.color[2];
+
+        float min_yf = MIN(p0.y, MIN(p1.y, p2.y));
+        float max_yf = MAX(p0.y, MAX(p1.y, p2.y));
+        int min_y = MAX((int)floorf(min_yf), row_begin);
+        int max_y = MIN((int)ceilf(max_yf), row_end - 1);
+        if(min_y > max_y){
+            return;
+        }
+        int min_x = MAX((int)floorf(MIN(p0.x, MIN(p1.x, p2.x))), 0);
+        int max_x = MIN((int)ceilf(MAX(p0.x, MAX(p1.x, p2.x))), SIZE - 1);
+        if(min_x > max_x){
+            return;
+        }
+
+        float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+        if(area == 0.0f){
+            return;
+        }
+        if(area < 0.0f){
+            std::swap(p1, p2);
+            std::swap(c1, c2);
+            area = -area;
+        }
+        const float inv_area = 1.0f / area;
+
+        // edge i is opposite to vertex i, E(p) = A * x + B * y + C
+        const float A0 = p1.y - p2.y, B0 = p2.x - p1.x, C0 = p1.x * p2.y - p1.y * p2.x;
+        const float A1 = p2.y - p0.y, B1 = p0.x - p2.x, C1 = p2.x * p0.y - p2.y * p0.x;
+        const float A2 = p0.y - p1.y, B2 = p1.x - p0.x, C2 = p0.x * p1.y - p0.y * p1.x;
+
+#ifdef RASTER_SSE2
+        const __m128 lane = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        const __m128i lane_index = _mm_set_epi32(3, 2, 1, 0);
+        const __m128i end = _mm_set1_epi32(max_x + 1);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+        const __m128 inv = _mm_set1_ps(inv_area);
+#endif
+
+        for(int y = min_y; y <= max_y; y++){
+            const float py = y + 0.5f;
+            const float row0 = B0 * py + C0;
+            const float row1 = B1 * py + C1;
+            const float row2 = B2 * py + C2;
+            uint32 *row = &framebuffer[y * STRIDE];
+            int x = min_x;
+
+#ifdef RASTER_SSE2
+            for(; x <= max_x; x += 4){
+                __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lane);
+                __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A0), px), _mm_set1_ps(row0));
+                __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A1), px), _mm_set1_ps(row1));
+                __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A2), px), _mm_set1_ps(row2));
+                __m128 inside = _mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_and_ps(_mm_cmpge_ps(w1, zero), _mm_cmpge_ps(w2, zero)));
+                __m128i in_row = _mm_cmplt_epi32(_mm_add_epi32(_mm_set1_epi32(x), lane_index), end);
+                __m128i mask = _mm_and_si128(_mm_castps_si128(inside), in_row);
+                if(_mm_movemask_epi8(mask) == 0){
+                    continue;
+                }
+
+                __m128 b0 = _mm_mul_ps(w0, inv);
+                __m128 b1 = _mm_mul_ps(w1, inv);
+                __m128 b2 = _mm_mul_ps(w2, inv);
+                __m128 r = _mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c0.r)), _mm_add_ps(_mm_mul_ps(b1, _mm_set1_ps(c1.r)), _mm_mul_ps(b2, _mm_set1_ps(c2.r))));
+                __m128 g = _mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c0.g)), _mm_add_ps(_mm_mul_ps(b1, _mm_set1_ps(c1.g)), _mm_mul_ps(b2, _mm_set1_ps(c2.g))));
+                __m128 b = _mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(c0.b)), _mm_add_ps(_mm_mul_ps(b1, _mm_set1_ps(c1.b)), _mm_mul_ps(b2, _mm_set1_ps(c2.b))));
+                __m128i ir = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(r, zero), one), scale));
+                __m128i ig = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(g, zero), one), scale));
+                __m128i ib = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(b, zero), one), scale));
+                __m128i color = _mm_or_si128(_mm_or_si128(ir, _mm_slli_epi32(ig, 8)), _mm_or_si128(_mm_slli_epi32(ib, 16), alpha));
+
+                __m128i old = _mm_loadu_si128((__m128i*)&row[x]);
+                __m128i blended = _mm_or_si128(_mm_and_si128(mask, color), _mm_andnot_si128(mask, old));
+                _mm_storeu_si128((__m128i*)&row[x], blended);
+            }
+#else
+            for(; x <= max_x; x++){
+                const float px = x + 0.5f;
+                float w0 = A0 * px + row0;
+                float w1 = A1 * px + row1;
+                float w2 = A2 * px + row2;
+                if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f){
+                    continue;
+                }
+                w0 *= inv_area;
+                w1 *= inv_area;
+                w2 *= inv_area;
+                vec3 c = c0 * w0 + c1 * w1 + c2 * w2;
+                row[x] = packColor(c.r, c.g, c.b);
+            }
+#endif
+        }
+    }
+
+    static void rasterize(int row_begin, int row_end){
+        for(const Triangle &tri : triangles){
+            rasterizeTriangle(tri, row_begin, row_end);
+        }
+    }
+
+    static void writeImage(uint64 tick){
+        char path[256];
+        snprintf(path, sizeof(path), "%sworld_%08llu.ppm", config::RENDER_SOFTWARE_DIRECTORY.c_str(), (unsigned long long)tick);
+        FILE *file = fopen(path, "wb");
+        if(file == nullptr){
+            cout << "[rendering_software] could not write " << path << endl;
+            return;
+        }
+        fprintf(file, "P6\n%d %d\n255\n", SIZE, SIZE);
+        std::vector<ubyte> rgb(SIZE * 3);
+        for(int y = 0; y < SIZE; y++){
+            for(int x = 0; x < SIZE; x++){
+                rgb[x * 3 + 0] = image[(y * SIZE + x) * 4 + 0];
+                rgb[x * 3 + 1] = image[(y * SIZE + x) * 4 + 1];
+                rgb[x * 3 + 2] = image[(y * SIZE + x) * 4 + 2];
+            }
+            fwrite(rgb.data(), 1, rgb.size(), file);
+        }
+        fclose(file);
+    }
+}
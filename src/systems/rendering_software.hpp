@@ -0,0 +1,17 @@
+#pragma once
+#include "engine/common.hpp"
+#include "ecs.hpp"
+
+/* Read only system, cpu fallback of rendering for machines without gpu */
+namespace rendering_software {
+
+    void initialize();
+
+    void cleanup();
+
+    // rasterizes the world every RENDER_SOFTWARE_INTERVAL ticks and writes it to disk
+    void update(float real_delta, uint64 tick);
+
+    // rasterizes the world into a top down RGBA image of RENDER_SOFTWARE_RESOLUTION²
+    const ubyte* render();
+}
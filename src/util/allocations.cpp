@@ -0,0 +1,62 @@
+#include "util/allocations.hpp"
+#include "engine/common.hpp"
+#include <new>
+#include <cstdlib>
+
+namespace allocations {
+
+    static thread_local uint64 count = 0;
+
+#ifndef NDEBUG
+    static void* allocate(size_t bytes){
+        count++;
+        void *p = malloc(bytes > 0 ? bytes : 1);
+        if(p == nullptr){
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+#endif
+
+    uint64 getCount(){
+        return count;
+    }
+
+    void add(uint64 allocated){
+        count += allocated;
+    }
+
+    bool isCounting(){
+#ifndef NDEBUG
+        return true;
+#else
+        return false;
+#endif
+    }
+}
+
+#ifndef NDEBUG
+void* operator new(size_t bytes){
+    return allocations::allocate(bytes);
+}
+
+void* operator new[](size_t bytes){
+    return allocations::allocate(bytes);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+    free(p);
+}
+#endif
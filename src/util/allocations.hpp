@@ -0,0 +1,15 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Heap allocation counter, debug builds replace the global operator new to count per thread */
+namespace allocations {
+
+    // allocations made by the calling thread so far, including those of pool workers helping its parallel loops,
+    // always 0 in release builds
+    uint64 getCount();
+
+    // credits allocations that helper threads made on behalf of the calling thread
+    void add(uint64 allocated);
+
+    bool isCounting();
+}
@@ -0,0 +1,273 @@
+#include "util/benchmark.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "systems/creatures_generator.hpp"
+#include "systems/creatures_thinking.hpp"
+#include "systems/environment.hpp"
+#include "systems/physics.hpp"
+#include "util/markov_name.hpp"
+#include <chrono>
+#include <fstream>
+
+namespace benchmark {
+
+    using namespace ecs;
+    typedef std::chrono::steady_clock Clock;
+
+    struct Result {
+        string name;
+        string unit;
+        double value;
+        uint64 iterations;
+    };
+
+    struct Scenario {
+        const char *name;
+        int creatures;
+        float growth_rate;
+        uint64 ticks;
+        Appendage::Type appendages;
+        bool birth_storm;
+    };
+
+    static const Scenario scenarios[] = {
+        {"sparse",      100,  500.0f,                                                  config::BENCHMARK_TICKS,      Appendage::NONE, false},
+        {"packed",      1000, config::SIM_MAX_ENTITIES - config::SIM_MAX_CREATURES,   config::BENCHMARK_TICKS,      Appendage::NONE, false},
+        {"birth_storm", 1000, 5000.0f,                                                 config::BENCHMARK_TICKS / 10, Appendage::NONE, true},
+        {"all_eyes",    1000, 5000.0f,                                                 config::BENCHMARK_TICKS,      Appendage::EYE,  false},
+    };
+
+    static std::vector<Result> results;
+    static volatile float sink = 0.0f;     // keeps results of pure functions alive
+
+    static double elapsed(Clock::time_point start){
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static void report(const string &name, const string &unit, double value, uint64 iterations){
+        results.push_back({name, unit, value, iterations});
+        cout << TERMINAL_COLOR << "[benchmark] " << name << ": " << value << " " << unit << " (" << iterations << ")" << TERMINAL_CLEAR << endl;
+    }
+
+    static void populate(int creatures, float growth_rate, Appendage::Type appendages){
+        ecs::clear();
+        ecs::seedRandom(config::SIM_SEED);
+        environment::setGrowthRate(growth_rate);
+        creatures_generator::setAppendageOverride(appendages);
+        environment::populate(creatures);
+    }
+
+    static bool hasFetus(){
+        for(const CreatureData &creature : world->creature_data.vector){
+            if(creature.state == CreatureData::FETUS){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // the generator commits a queue of fetuses per tick, a few ticks after birth
+    static void warmUp(void (*step)()){
+        for(int i = 0; i < config::BENCHMARK_WARMUP_TICKS && hasFetus(); i++){
+            step();
+        }
+    }
+
+    /* MICRO BENCHMARKS, run on the default world */
+
+    static void benchmarkRaycast(){
+        const uint64 n = 200000;
+        std::vector<vec2> origins(n);
+        std::vector<vec2> normals(n);
+        for(uint64 i = 0; i < n; i++){
+            origins[i] = world->physics_bodies.vector[i % world->physics_bodies.vector.size()].position;
+            float angle = randf(0.0f, 2.0f * PI);
+            normals[i] = vec2(cosf(angle), sinf(angle));
+        }
+        Clock::time_point start = Clock::now();
+        size_t hits = 0;
+        for(uint64 i = 0; i < n; i++){
+            hits += physics::raycast(origins[i], normals[i], config::CREATURE_EYE_RANGE).hit_id != INVALID_CID;
+        }
+        report("physics::raycast", "ns/op", elapsed(start) * 1e9 / n, n);
+        sink = (float)hits;
+    }
+
+    static void benchmarkQueries(){
+        const uint64 n = 200000;
+        std::vector<vec2> points(n);
+        for(uint64 i = 0; i < n; i++){
+            points[i] = vec2(randf(0.0f, config::PHYSICS_MAP_WIDTH), randf(0.0f, config::PHYSICS_MAP_WIDTH));
+        }
+        CID out[8];
+        size_t hits = 0;
+        Clock::time_point start = Clock::now();
+        for(uint64 i = 0; i < n; i++){
+            hits += physics::queryPoint(points[i], out, 8);
+        }
+        report("physics::queryPoint", "ns/op", elapsed(start) * 1e9 / n, n);
+
+        start = Clock::now();
+        for(uint64 i = 0; i < n; i++){
+            hits += physics::queryNearest(points[i], config::CREATURE_MATE_RADIUS, out, 8);
+        }
+        report("physics::queryNearest", "ns/op", elapsed(start) * 1e9 / n, n);
+        sink = (float)hits;
+    }
+
+    static void benchmarkCollisionPair(){
+        // neighbours in component order, mostly misses like the broadphase candidates
+        std::vector<CID> pairs;
+        for(CID cid = 0; cid + 1 < world->physics_bodies.vector.size(); cid++){
+            pairs.push_back(cid);
+            pairs.push_back(cid + 1);
+        }
+        const int rounds = 100;
+        size_t count = pairs.size() / 2;
+        Clock::time_point start = Clock::now();
+        for(int r = 0; r < rounds; r++){
+            physics::solveCollisionPairs(pairs.data(), count);
+        }
+        report("physics::solveCollisionPair", "ns/op", elapsed(start) * 1e9 / (rounds * count), rounds * count);
+    }
+
+    static void benchmarkRegions(){
+        const int n = 200;
+        Clock::time_point start = Clock::now();
+        for(int i = 0; i < n; i++){
+            physics::registerRegionMembers();
+        }
+        report("physics::registerRegionMembers", "ns/op", elapsed(start) * 1e9 / n, n);
+    }
+
+    static void benchmarkThinking(){
+        const int n = 50;
+        Clock::time_point start = Clock::now();
+        for(int i = 0; i < n; i++){
+            creatures_thinking::update();
+        }
+        report("creatures_thinking::update/creature", "ns/op", elapsed(start) * 1e9 / (n * world->cellsAlive), n * world->cellsAlive);
+    }
+
+    static void benchmarkGenerator(){
+        const int traits = 100000;
+        Clock::time_point start = Clock::now();
+        sink = creatures_generator::generateTraits(world->creature_data.vector[0].dna, config::CREATURE_GENERATOR_SEED, traits);
+        report("creatures_generator::generateTrait", "ns/op", elapsed(start) * 1e9 / traits, traits);
+
+        const int creatures = MIN(50, (int)world->creature_data.vector.size());
+        start = Clock::now();
+        for(int i = 0; i < creatures; i++){
+            creatures_generator::generateCreature(i);
+        }
+        report("creatures_generator::generateCreature", "ns/op", elapsed(start) * 1e9 / creatures, creatures);
+    }
+
+    static void benchmarkComponentVector(){
+        ComponentVector<PhysicsBody> components;
+        components.setCapacity(config::SIM_MAX_ENTITIES, config::SIM_MAX_ENTITIES);
+        std::vector<ID> order(config::SIM_MAX_ENTITIES);
+        for(ID id = 0; id < order.size(); id++){
+            order[id] = id;
+        }
+        for(size_t i = order.size() - 1; i > 0; i--){
+            std::swap(order[i], order[rand() % (i + 1)]);
+        }
+
+        const int rounds = 100;
+        double add_time = 0.0;
+        double remove_time = 0.0;
+        for(int r = 0; r < rounds; r++){
+            Clock::time_point start = Clock::now();
+            for(ID id = 0; id < order.size(); id++){
+                components.add(id);
+            }
+            add_time += elapsed(start);
+            start = Clock::now();
+            for(ID id : order){
+                components.remove(id);
+            }
+            remove_time += elapsed(start);
+        }
+        uint64 ops = rounds * order.size();
+        report("ComponentVector::add", "ns/op", add_time * 1e9 / ops, ops);
+        report("ComponentVector::remove", "ns/op", remove_time * 1e9 / ops, ops);
+    }
+
+    static void benchmarkNames(){
+        const int n = 20000;
+        size_t length = 0;
+        Clock::time_point start = Clock::now();
+        for(int i = 0; i < n; i++){
+            length += markov_name::generateWord(4, 16).size();
+        }
+        report("markov_name::generateWord", "ns/op", elapsed(start) * 1e9 / n, n);
+        sink = (float)length;
+    }
+
+    /* MACRO SCENARIOS */
+
+    static void runScenario(const Scenario &scenario, void (*step)(), uint64 ticks){
+        populate(scenario.creatures, scenario.growth_rate, scenario.appendages);
+
+        // first ticks generate the initial population
+        warmUp(step);
+
+        Clock::time_point start = Clock::now();
+        for(uint64 t = 0; t < ticks; t++){
+            if(scenario.birth_storm){
+                // a tenth of the population is fed to the birth threshold every tick
+                for(CID cid = t % 10; cid < world->creature_data.vector.size(); cid += 10){
+                    CreatureData &creature = world->creature_data.vector[cid];
+                    if(creature.state == CreatureData::ALIVE){
+                        creature.energy = config::CREATURE_MAX_ENERGY * creature.size * creature.size;
+                    }
+                }
+            }
+            step();
+        }
+        report("scenario/" + string(scenario.name), "ticks/s", ticks / elapsed(start), ticks);
+    }
+
+    static void write(const string &path){
+        std::ofstream file(path);
+        if(!file){
+            cout << TERMINAL_COLOR << "[benchmark] could not write " << path << TERMINAL_CLEAR << endl;
+            return;
+        }
+        file << "{\n";
+        file << "  \"seed\": " << config::SIM_SEED << ",\n";
+        file << "  \"results\": [\n";
+        for(size_t i = 0; i < results.size(); i++){
+            file << "    {\"name\": \"" << results[i].name << "\", \"unit\": \"" << results[i].unit << "\", ";
+            file << "\"value\": " << results[i].value << ", \"iterations\": " << results[i].iterations << "}";
+            file << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        file << "  ]\n";
+        file << "}\n";
+    }
+
+    void run(const string &path, void (*step)(), uint64 ticks){
+        results.clear();
+
+        populate(1000, 5000.0f, Appendage::NONE);
+        warmUp(step);
+        benchmarkRegions();
+        benchmarkRaycast();
+        benchmarkQueries();
+        benchmarkCollisionPair();
+        benchmarkThinking();
+        benchmarkGenerator();
+        benchmarkComponentVector();
+        benchmarkNames();
+
+        for(const Scenario &scenario : scenarios){
+            runScenario(scenario, step, ticks > 0 ? ticks : scenario.ticks);
+        }
+        creatures_generator::setAppendageOverride(Appendage::NONE);
+
+        write(path);
+        cout << TERMINAL_COLOR << "[benchmark] results written to " << path << TERMINAL_CLEAR << endl;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Micro benchmarks of the hot functions and headless macro scenarios */
+namespace benchmark {
+    static string TERMINAL_COLOR = "\033[1;33m";
+
+    // step advances the simulation by one tick, ticks overrides the scenario lengths if > 0
+    // results are printed and written as json to path
+    void run(const string &path, void (*step)(), uint64 ticks);
+}
@@ -0,0 +1,272 @@
+#include "util/capture.hpp"
+
+#include "engine/common.hpp"
+#include "engine/framebuffer.hpp"
+#include "config.hpp"
+#include "util/files.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+
+// _popen needs binary mode for the raw frames, POSIX popen only accepts "r" or "w"
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#define POPEN_WRITE "wb"
+#else
+#define POPEN_WRITE "w"
+#endif
+
+namespace capture {
+
+    static constexpr int WIDTH = config::CAPTURE_RESOLUTION_X;
+    static constexpr int HEIGHT = config::CAPTURE_RESOLUTION_Y;
+    static constexpr int FRAME_BYTES = WIDTH * HEIGHT * 4;
+
+    static Framebuffer target;
+    static bool enabled = false;
+    static uint64 next_tick = 0;
+
+    // readback ring, oldest pending slot is at tail
+    static GLuint pbos[config::CAPTURE_PBO_COUNT];
+    static GLsync fences[config::CAPTURE_PBO_COUNT];
+    static int pbo_head = 0;
+    static int pbo_tail = 0;
+    static int pbo_pending = 0;
+
+    // frame buffers shared with the writer thread
+    static std::vector<ubyte> frames[config::CAPTURE_QUEUE_SIZE];
+    static std::queue<int> free_frames;
+    static std::queue<int> written_frames;
+    static std::mutex frame_mutex;
+    static std::condition_variable frame_signal;
+    static std::thread writer;
+    static bool writer_quit = false;
+
+    static uint64 frames_captured = 0;
+    static uint64 frames_dropped = 0;
+
+    static void writeFrames();
+
+    void initialize(){
+        for(int i = 0; i < config::CAPTURE_QUEUE_SIZE; i++){
+            frames[i].resize(FRAME_BYTES);
+            free_frames.push(i);
+        }
+        writer_quit = false;
+        writer = std::thread(writeFrames);
+        cout << TERMINAL_COLOR << "[capture] intitialized" << TERMINAL_CLEAR << endl;
+    }
+
+    void cleanup(){
+        // drain readbacks that already finished, drop the rest
+        update();
+        for(int i = 0; i < config::CAPTURE_PBO_COUNT; i++){
+            if(fences[i] != nullptr){
+                glDeleteSync(fences[i]);
+                fences[i] = nullptr;
+            }
+        }
+        if(target.fbo != 0){
+            glDeleteBuffers(config::CAPTURE_PBO_COUNT, pbos);
+            target.destroy();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(frame_mutex);
+            writer_quit = true;
+        }
+        frame_signal.notify_one();
+        if(writer.joinable()){
+            writer.join();
+        }
+        cout << TERMINAL_COLOR << "[capture] cleanup, " << frames_captured << " frames, " << frames_dropped << " dropped" << TERMINAL_CLEAR << endl;
+    }
+
+    static void createTargets(){
+        target.create(WIDTH, HEIGHT);
+        glGenBuffers(config::CAPTURE_PBO_COUNT, pbos);
+        for(int i = 0; i < config::CAPTURE_PBO_COUNT; i++){
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, FRAME_BYTES, nullptr, GL_STREAM_READ);
+            fences[i] = nullptr;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void setEnabled(bool e){
+        if(e && target.fbo == 0){
+            // gpu resources are only created once capturing is actually used
+            createTargets();
+        }
+        enabled = e;
+        cout << TERMINAL_COLOR << "[capture] " << (enabled ? "started" : "stopped") << TERMINAL_CLEAR << endl;
+    }
+
+    bool isEnabled(){
+        return enabled;
+    }
+
+    bool isDue(uint64 tick){
+        if(!enabled || tick < next_tick){
+            return false;
+        }
+        if(pbo_pending == config::CAPTURE_PBO_COUNT){
+            // gpu is behind, skip instead of stalling
+            frames_dropped++;
+            return false;
+        }
+        next_tick = tick + config::CAPTURE_INTERVAL;
+        return true;
+    }
+
+    void beginFrame(){
+        target.bind();
+        glViewport(0, 0, WIDTH, HEIGHT);
+    }
+
+    void endFrame(){
+        assert(pbo_pending < config::CAPTURE_PBO_COUNT);
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_head]);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        fences[pbo_head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        pbo_head = (pbo_head + 1) % config::CAPTURE_PBO_COUNT;
+        pbo_pending++;
+
+        target.unbind();
+    }
+
+    void update(){
+        while(pbo_pending > 0){
+            GLenum status = glClientWaitSync(fences[pbo_tail], 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED){
+                // oldest readback still in flight
+                return;
+            }
+            glDeleteSync(fences[pbo_tail]);
+            fences[pbo_tail] = nullptr;
+
+            int frame = -1;
+            {
+                std::lock_guard<std::mutex> lock(frame_mutex);
+                if(!free_frames.empty()){
+                    frame = free_frames.front();
+                    free_frames.pop();
+                }
+            }
+
+            if(frame == -1){
+                // writer is behind, drop frame
+                frames_dropped++;
+            }else{
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_tail]);
+                void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, FRAME_BYTES, GL_MAP_READ_BIT);
+                if(pixels != nullptr){
+                    memcpy(frames[frame].data(), pixels, FRAME_BYTES);
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                }
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                {
+                    std::lock_guard<std::mutex> lock(frame_mutex);
+                    written_frames.push(frame);
+                }
+                frame_signal.notify_one();
+                frames_captured++;
+            }
+
+            pbo_tail = (pbo_tail + 1) % config::CAPTURE_PBO_COUNT;
+            pbo_pending--;
+        }
+    }
+
+    int getWidth(){
+        return WIDTH;
+    }
+
+    int getHeight(){
+        return HEIGHT;
+    }
+
+    /* WRITER THREAD */
+
+    static void convertFrame(const ubyte *rgba, ubyte *rgb){
+        // gl rows are bottom up, drop alpha
+        for(int y = 0; y < HEIGHT; y++){
+            const ubyte *src = rgba + (HEIGHT - 1 - y) * WIDTH * 4;
+            ubyte *dst = rgb + y * WIDTH * 3;
+            for(int x = 0; x < WIDTH; x++){
+                dst[x * 3 + 0] = src[x * 4 + 0];
+                dst[x * 3 + 1] = src[x * 4 + 1];
+                dst[x * 3 + 2] = src[x * 4 + 2];
+            }
+        }
+    }
+
+    static void writeFrames(){
+        std::vector<ubyte> rgb(WIDTH * HEIGHT * 3);
+        FILE *encoder = nullptr;
+        bool use_encoder = !config::CAPTURE_ENCODER.empty();
+        uint64 frame_number = 0;
+        char path[256];
+
+        if(!use_encoder){
+            files::makeDirectory(config::CAPTURE_DIRECTORY);
+        }
+
+        while(true){
+            int frame;
+            {
+                std::unique_lock<std::mutex> lock(frame_mutex);
+                frame_signal.wait(lock, []{ return writer_quit || !written_frames.empty(); });
+                if(written_frames.empty()){
+                    break;
+                }
+                frame = written_frames.front();
+                written_frames.pop();
+            }
+
+            convertFrame(frames[frame].data(), rgb.data());
+
+            {
+                std::lock_guard<std::mutex> lock(frame_mutex);
+                free_frames.push(frame);
+            }
+
+            if(use_encoder){
+                if(encoder == nullptr){
+                    encoder = popen(config::CAPTURE_ENCODER.c_str(), POPEN_WRITE);
+                    if(encoder == nullptr){
+                        cout << TERMINAL_COLOR << "[capture] ERROR! could not start encoder" << TERMINAL_CLEAR << endl;
+                        use_encoder = false;
+                        files::makeDirectory(config::CAPTURE_DIRECTORY);
+                    }
+                }
+                if(encoder != nullptr){
+                    fwrite(rgb.data(), 1, rgb.size(), encoder);
+                    continue;
+                }
+            }
+
+            snprintf(path, sizeof(path), "%sframe_%06llu.ppm", config::CAPTURE_DIRECTORY.c_str(), (unsigned long long)frame_number++);
+            FILE *file = fopen(path, "wb");
+            if(file == nullptr){
+                cout << TERMINAL_COLOR << "[capture] ERROR! could not write " << path << TERMINAL_CLEAR << endl;
+                continue;
+            }
+            fprintf(file, "P6\n%d %d\n255\n", WIDTH, HEIGHT);
+            fwrite(rgb.data(), 1, rgb.size(), file);
+            fclose(file);
+        }
+
+        if(encoder != nullptr){
+            pclose(encoder);
+        }
+    }
+}
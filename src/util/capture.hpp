@@ -0,0 +1,30 @@
+#pragma once
+#include "engine/common.hpp"
+
+namespace capture {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    void initialize();
+
+    void cleanup();
+
+    void setEnabled(bool enabled);
+
+    bool isEnabled();
+
+    // true once every CAPTURE_INTERVAL ticks while enabled
+    bool isDue(uint64 tick);
+
+    // redirect rendering into the offscreen target, caller restores the viewport
+    void beginFrame();
+
+    // queue asynchronous readback of the offscreen target
+    void endFrame();
+
+    // hand finished readbacks to the writer thread, never blocks
+    void update();
+
+    int getWidth();
+
+    int getHeight();
+}
@@ -2,6 +2,7 @@
 
 #include "engine/shader.hpp"
 #include "engine/mesh.hpp"
+#include "config.hpp"
 
 
 namespace debuglines {
@@ -11,6 +12,8 @@ namespace debuglines {
 
     void initialize(){
         shader.compile("resources/color.vert", "resources/color.frag");
+        // points are added during the tick, which must not allocate
+        lineMesh.vertex_buffer.reserve(config::RENDER_DEBUG_POINTS);
         cout << TERMINAL_COLOR << "[debuglines] intitialized" << TERMINAL_CLEAR << endl;
     }
 
@@ -21,6 +24,9 @@ namespace debuglines {
     }
 
     void addPoint(vec2 p, vec3 color){
+        if(lineMesh.vertex_buffer.size() >= lineMesh.vertex_buffer.capacity()){
+            return;
+        }
         Mesh::Vertex v = {vec3(p.x, p.y, 0.0f), color, vec2()};
         lineMesh.vertex_buffer.push_back(v);
     }
@@ -37,4 +43,8 @@ namespace debuglines {
         lineMesh.upload(Mesh::STREAM, false);
         lineMesh.drawLines();
     }
+
+    Mesh::VertexBuffer& getPoints(){
+        return lineMesh.vertex_buffer;
+    }
 }
\ No newline at end of file
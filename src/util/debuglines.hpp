@@ -1,5 +1,6 @@
 #pragma once
 #include "engine/common.hpp"
+#include "engine/mesh.hpp"
 
 namespace debuglines {
     static string TERMINAL_COLOR = "\033[1;30m";
@@ -8,7 +9,11 @@ namespace debuglines {
 
     void cleanup();
 
+    // points past RENDER_DEBUG_POINTS in one frame are dropped
     void addPoint(vec2 p, vec3 color);
 
     void render(mat4 transformation, float line_width);
+
+    // points queued since the last render, consumed by the software renderer
+    Mesh::VertexBuffer& getPoints();
 }
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include "util/files.hpp"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace files {
+
+    bool makeDirectory(const string &path){
+#ifdef _WIN32
+        int result = _mkdir(path.c_str());
+#else
+        int result = mkdir(path.c_str(), 0755);
+#endif
+        return result == 0 || errno == EEXIST;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Small file system helpers shared by the writers */
+namespace files {
+
+    // creates the directory if it does not exist yet, parents must exist, true if it exists afterwards
+    bool makeDirectory(const string &path);
+}
@@ -0,0 +1,62 @@
+#include "util/frame_arena.hpp"
+#include "engine/common.hpp"
+#include "config.hpp"
+
+namespace frame_arena {
+
+    struct Chunk {
+        std::unique_ptr<ubyte[]> memory;
+        size_t size;
+    };
+
+    // chunks are kept for the next tick, a tick larger than all before adds one
+    struct Arena {
+        std::vector<Chunk> chunks;
+        size_t chunk = 0;
+        size_t offset = 0;
+    };
+
+    static thread_local Arena arena;
+
+    void* allocate(size_t bytes, size_t alignment){
+        while(true){
+            if(arena.chunk < arena.chunks.size()){
+                Chunk &c = arena.chunks[arena.chunk];
+                uintptr_t base = (uintptr_t)c.memory.get();
+                size_t start = ((base + arena.offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+                if(start + bytes <= c.size){
+                    arena.offset = start + bytes;
+                    return c.memory.get() + start;
+                }
+                if(arena.chunk + 1 < arena.chunks.size()){
+                    arena.chunk++;
+                    arena.offset = 0;
+                    continue;
+                }
+            }
+            // the slack covers aligning the start of a chunk
+            size_t size = MAX((size_t)config::FRAME_ARENA_CHUNK, bytes + alignment);
+            arena.chunks.push_back({std::unique_ptr<ubyte[]>(new ubyte[size]), size});
+            arena.chunk = arena.chunks.size() - 1;
+            arena.offset = 0;
+        }
+    }
+
+    Scope::Scope(){
+        chunk = arena.chunk;
+        offset = arena.offset;
+    }
+
+    Scope::~Scope(){
+        arena.chunk = chunk;
+        arena.offset = offset;
+    }
+
+    size_t getCapacity(){
+        size_t bytes = 0;
+        for(const Chunk &c : arena.chunks){
+            bytes += c.size;
+        }
+        return bytes;
+    }
+}
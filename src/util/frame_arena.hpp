@@ -0,0 +1,54 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Per thread linear scratch memory, everything allocated inside a scope is released at once when it closes */
+namespace frame_arena {
+
+    // bump allocation from the calling thread's arena, only valid until the innermost open scope closes
+    void* allocate(size_t bytes, size_t alignment = 16);
+
+    template <class T>
+    T* allocate(size_t count){
+        return (T*)allocate(sizeof(T) * count, alignof(T) > 16 ? alignof(T) : 16);
+    }
+
+    // rewinds the calling thread's arena to where it was when the scope opened
+    // system_graph opens one per tick and per system task, so systems never release anything themselves
+    class Scope {
+        public:
+            Scope();
+            ~Scope();
+        private:
+            size_t chunk;
+            size_t offset;
+    };
+
+    // bytes reserved by the calling thread's arena, stops growing once the largest tick has been seen
+    size_t getCapacity();
+
+    // lets std containers live in the arena, deallocation is a no-op until the scope closes
+    template <class T>
+    struct Allocator {
+        typedef T value_type;
+
+        Allocator() = default;
+
+        template <class U>
+        Allocator(const Allocator<U>&){}
+
+        T* allocate(size_t count){
+            return frame_arena::allocate<T>(count);
+        }
+
+        void deallocate(T*, size_t){}
+
+        template <class U>
+        bool operator==(const Allocator<U>&) const { return true; }
+
+        template <class U>
+        bool operator!=(const Allocator<U>&) const { return false; }
+    };
+
+    template <class T>
+    using Vector = std::vector<T, Allocator<T>>;
+}
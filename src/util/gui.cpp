@@ -2,6 +2,7 @@
 
 #include "util/mesher_primitive.hpp"
 #include "engine/common.hpp"
+#include <cstring>
 #include "engine/mesh.hpp"
 #include "engine/texture.hpp"
 #include "engine/shader.hpp"
@@ -11,7 +12,8 @@ namespace gui{
 
     static Shader shader;
     static Texture fontTexture;
-    static Mesh mesh;
+    static Mesh glyph_mesh;
+    static std::vector<float> glyph_instances;
 
     static constexpr int CHARS_TOTAL = 256;
     static const int CHARS_FIRST = 32;
@@ -62,35 +64,60 @@ namespace gui{
     }
 
     void initialize(){
-        shader.compile("resources/texture.vert", "resources/texture.frag");
+        shader.compile("resources/text_instance.vert", "resources/texture.frag");
         fontTexture.create("resources/calibri32clean.bmp", false);
         fontTexture.convert_black_to_alpha();
         fontTexture.upload(true);
         generate_char_uvs();
         // texture unit 0
         shader.setUniformInteger(1, 0);
+
+        // unit quad, every glyph is an instance of it
+        glyph_mesh.instance_layout = {4, 4, 3};
+        mesher_primitive::quad(glyph_mesh.vertex_buffer, glyph_mesh.index_buffer, vec3(0.0f), vec2(1.0f), vec2(0.0f), vec2(1.0f), COLOR_WHITE);
+        glyph_mesh.upload(Mesh::STATIC, true);
+        glyph_instances.reserve(4096 * GLYPH_FLOATS);
         cout << TERMINAL_COLOR << "[gui] intitialized" << TERMINAL_CLEAR << endl;
     }
 
     void cleanup(){
         shader.destroy();
         fontTexture.destroy();
-        mesh.destroy();
+        glyph_mesh.destroy();
         cout << TERMINAL_COLOR << "[gui] cleanup" << TERMINAL_CLEAR << endl;
     }
 
+    static inline void writeGlyph(float *out, float x, float y, float w, float h, vec4 uv, vec3 color){
+        out[0] = x;
+        out[1] = y;
+        out[2] = w;
+        out[3] = h;
+        out[4] = uv[0];
+        out[5] = uv[1];
+        out[6] = uv[2];
+        out[7] = uv[3];
+        out[8] = color.r;
+        out[9] = color.g;
+        out[10] = color.b;
+    }
+
+    static inline void pushGlyph(float x, float y, float w, float h, vec4 uv, vec3 color){
+        size_t n = glyph_instances.size();
+        glyph_instances.resize(n + GLYPH_FLOATS);
+        writeGlyph(&glyph_instances[n], x, y, w, h, uv, color);
+    }
+
     void drawBox(float x, float y, float w, float h, vec3 color){
-        mesher_primitive::quad(mesh.vertex_buffer, mesh.index_buffer, vec3(x, y, 0.0f), vec2(w, h), vec2(0.999f, 0.999f), vec2(0.0f, 0.0f), color);
+        pushGlyph(x, y, w, h, vec4(0.999f, 0.999f, 0.0f, 0.0f), color);
     }
 
     void drawChar(int character, float x, float y, float w, float h, vec3 color){
         assert(character >= CHARS_FIRST && character < CHARS_FIRST + CHARS_TOTAL);
         character = character - CHARS_FIRST;
-        vec4 uvs = char_uvs[character];
-        mesher_primitive::quad(mesh.vertex_buffer, mesh.index_buffer, vec3(x, y, 0.0f), vec2(w, h), vec2(uvs[0], uvs[1]), vec2(uvs[2], uvs[3]), color);
+        pushGlyph(x, y, w, h, char_uvs[character], color);
     }
 
-    void drawString(string text, float x, float y, float w, float h, vec3 color){
+    void drawString(const string &text, float x, float y, float w, float h, vec3 color){
         int n = text.size();
         assert(n > 0);
 
@@ -113,7 +140,7 @@ namespace gui{
         }
     }
 
-    void drawStringUnscaled(string text, float x, float y, float scale, vec3 color){
+    void drawStringUnscaled(const string &text, float x, float y, float scale, vec3 color){
         int n = text.size();
 
         float accumulator = x;
@@ -127,8 +154,92 @@ namespace gui{
         }
     }
 
+    /* RETAINED TEXT */
+
+    void setText(Text &text, const char *str){
+        if(text.format == Text::STRING && strncmp(text.buffer, str, TEXT_MAX_LENGTH) == 0){
+            return;
+        }
+        strncpy(text.buffer, str, TEXT_MAX_LENGTH);
+        text.buffer[TEXT_MAX_LENGTH] = '\0';
+        text.length = strlen(text.buffer);
+        text.format = Text::STRING;
+        text.dirty = true;
+    }
+
+    void setInt(Text &text, int value){
+        if(text.format == Text::INT && text.value == (uint64)(int64)value){
+            return;
+        }
+        text.length = snprintf(text.buffer, sizeof(text.buffer), "%d", value);
+        text.format = Text::INT;
+        text.value = (uint64)(int64)value;
+        text.dirty = true;
+    }
+
+    void setFloat(Text &text, float value){
+        uint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        if(text.format == Text::FLOAT && text.value == bits){
+            return;
+        }
+        text.length = snprintf(text.buffer, sizeof(text.buffer), "%.2f", value);
+        text.format = Text::FLOAT;
+        text.value = bits;
+        text.dirty = true;
+    }
+
+    void setHex(Text &text, const ubyte *data, int size){
+        assert(size > 0 && size <= 8);
+        uint64 bits = 0;
+        memcpy(&bits, data, size);
+        if(text.format == Text::HEX && text.value == bits && text.length == size * 2){
+            return;
+        }
+        static const char digits[] = "0123456789abcdef";
+        for(int i = 0; i < size; i++){
+            text.buffer[i * 2 + 0] = digits[data[i] >> 4];
+            text.buffer[i * 2 + 1] = digits[data[i] & 0xF];
+        }
+        text.buffer[size * 2] = '\0';
+        text.length = size * 2;
+        text.format = Text::HEX;
+        text.value = bits;
+        text.dirty = true;
+    }
+
+    void placeText(Text &text, float x, float y, float scale, vec3 color){
+        if(text.x == x && text.y == y && text.scale == scale && text.color == color){
+            return;
+        }
+        text.x = x;
+        text.y = y;
+        text.scale = scale;
+        text.color = color;
+        text.dirty = true;
+    }
+
+    void drawText(Text &text){
+        if(text.dirty){
+            float accumulator = text.x;
+            for(int i = 0; i < text.length; i++){
+                int c = text.buffer[i] - CHARS_FIRST;
+                vec4 uv = char_uvs[c];
+                float w = text.scale * uv[2] / uv[3];
+                writeGlyph(&text.glyphs[i * GLYPH_FLOATS], accumulator, text.y, w, text.scale, uv, text.color);
+                accumulator += w;
+            }
+            text.dirty = false;
+        }
+
+        size_t n = glyph_instances.size();
+        size_t floats = text.length * GLYPH_FLOATS;
+        glyph_instances.resize(n + floats);
+        memcpy(&glyph_instances[n], text.glyphs, floats * sizeof(float));
+    }
+
     void render(){
-        if(mesh.vertex_buffer.size() > 0){
+        if(glyph_instances.size() > 0){
             mat4 to_ndc = {
                 2.0f, 0.0f, 0.0f, 0.0f,
                 0.0f, 2.0f, 0.0f, 0.0f,
@@ -138,8 +249,8 @@ namespace gui{
             shader.load();
             fontTexture.load();
             shader.setUniformMat4(0, to_ndc);
-            mesh.upload(Mesh::STREAM, false);
-            mesh.draw();
+            glyph_mesh.drawInstances(glyph_instances, Mesh::STREAM);
+            glyph_instances.clear();
         }
     }
 }
\ No newline at end of file
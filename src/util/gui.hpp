@@ -4,6 +4,33 @@
 namespace gui{
     static string TERMINAL_COLOR = "\033[1;30m";
 
+    static constexpr int TEXT_MAX_LENGTH = 32;
+    static constexpr int GLYPH_FLOATS = 11;     // rect xywh, uv xywh, rgb
+
+    // retained text line, glyph quads are only rebuilt when content or placement change
+    struct Text {
+        char buffer[TEXT_MAX_LENGTH + 1] = {0};
+        int length = 0;
+
+        float x = 0.0f;
+        float y = 0.0f;
+        float scale = 0.0f;
+        vec3 color = COLOR_WHITE;
+
+        // last formatted value, skips formatting if unchanged
+        enum Format {
+            NONE,
+            STRING,
+            INT,
+            FLOAT,
+            HEX
+        } format = NONE;
+        uint64 value = 0;
+
+        float glyphs[TEXT_MAX_LENGTH * GLYPH_FLOATS];
+        bool dirty = true;
+    };
+
     void initialize();
 
     void cleanup();
@@ -12,12 +39,21 @@ namespace gui{
 
     void drawChar(int character, float x, float y, float w, float h, vec3 color);
 
-    void drawString(string text, float x, float y, float w, float h, vec3 color);
+    void drawString(const string &text, float x, float y, float w, float h, vec3 color);
 
-    void drawStringUnscaled(string text, float x, float y, float scale, vec3 color);
+    void drawStringUnscaled(const string &text, float x, float y, float scale, vec3 color);
 
-    void render();
-}
+    void setText(Text &text, const char *str);
+
+    void setInt(Text &text, int value);
 
+    void setFloat(Text &text, float value);
 
+    void setHex(Text &text, const ubyte *data, int size);
 
+    void placeText(Text &text, float x, float y, float scale, vec3 color);
+
+    void drawText(Text &text);
+
+    void render();
+}
@@ -0,0 +1,69 @@
+#include "util/islands.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "systems/environment.hpp"
+#include "systems/physics.hpp"
+#include "util/thread_pool.hpp"
+#include <chrono>
+
+namespace islands {
+
+    static void migrate(std::vector<ecs::World*> &worlds){
+        // ring topology, island i sends to island i + 1
+        std::vector<std::vector<environment::Migrant>> outgoing(worlds.size());
+        for(size_t i = 0; i < worlds.size(); i++){
+            ecs::bindWorld(worlds[i]);
+            environment::emigrate(config::ISLAND_MIGRANTS, outgoing[i]);
+        }
+        for(size_t i = 0; i < worlds.size(); i++){
+            ecs::bindWorld(worlds[(i + 1) % worlds.size()]);
+            environment::immigrate(outgoing[i]);
+        }
+    }
+
+    void run(int count, uint64 ticks, void (*step)()){
+        ecs::World *home = ecs::world;
+        std::vector<ecs::World*> worlds(count);
+        for(int i = 0; i < count; i++){
+            worlds[i] = ecs::createWorld(config::SIM_SEED + i);
+            ecs::bindWorld(worlds[i]);
+            physics::initialize();
+            environment::populate(config::ISLAND_CREATURES);
+        }
+        cout << TERMINAL_COLOR << "[islands] running " << count << " islands on " << thread_pool::getThreadCount() << " threads" << TERMINAL_CLEAR << endl;
+
+        uint64 tick = 0;
+        while(ticks == 0 || tick < ticks){
+            uint64 span = config::ISLAND_MIGRATION_INTERVAL;
+            if(ticks > 0){
+                span = MIN(span, ticks - tick);
+            }
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            thread_pool::parallelFor(count, [&](int i){
+                ecs::bindWorld(worlds[i]);
+                for(uint64 t = 0; t < span; t++){
+                    step();
+                }
+            });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            tick += span;
+
+            if(count > 1){
+                migrate(worlds);
+            }
+
+            cout << TERMINAL_COLOR << "[islands] tick " << tick << ", " << (span * count / seconds) << " world ticks/s, creatures";
+            for(ecs::World *w : worlds){
+                cout << " " << w->cellsAlive;
+            }
+            cout << TERMINAL_CLEAR << endl;
+        }
+
+        for(ecs::World *w : worlds){
+            ecs::destroyWorld(w);
+        }
+        ecs::bindWorld(home);
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Island model, many independent worlds in one process with periodic migration between them */
+namespace islands {
+    static string TERMINAL_COLOR = "\033[1;32m";
+
+    // steps count worlds in parallel on the thread pool until ticks (0 runs forever)
+    // step advances the bound world by one tick
+    void run(int count, uint64 ticks, void (*step)());
+}
@@ -1,4 +1,5 @@
 #include "util/markov_name.hpp"
+#include "ecs.hpp"
 
 #include <fstream>
 #include <ctime>
@@ -76,13 +77,14 @@ namespace markov_name {
 
     }
 
+    // draws from the random stream of the bound world, so names are deterministic per world and thread safe
     std::string generateWord(int min_length, int max_length){
-        int last_char = rand() % 26;
+        int last_char = ecs::randomInt() % 26;
         std::string result = "";
         result += (char)(last_char + 'a');
 
         for(int i = 0; i < max_length; i++){
-            float r = (rand() / (float) RAND_MAX);
+            float r = ecs::randomFloat(0.0f, 1.0f);
             for(int t = 0; t < 27; t++){
                 if(r <= states[last_char].transition[t]){
                     if(t == 26){
@@ -0,0 +1,387 @@
+#include "util/migration.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "systems/environment.hpp"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+typedef SOCKET Socket;
+#define closeSocket closesocket
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <csignal>
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#endif
+
+// a closed peer must fail the send instead of raising SIGPIPE, where the flag is missing SIGPIPE is ignored
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0
+#endif
+
+namespace migration {
+
+    /*
+        protocol, all integers little endian
+        header:  uint32 magic, uint32 migrant count, uint32 payload bytes
+        migrant: dna[CREATURE_DNA_SIZE], int32 generations, int32 mutations, uint8 name length, name
+    */
+    static constexpr uint32 MAGIC = 0x4D4F5645;        // "EVOM"
+    static constexpr size_t HEADER_SIZE = 12;
+    static constexpr size_t MAX_PAYLOAD = 64 * 1024 * 1024;
+
+    static std::thread network_thread;
+    static std::atomic<bool> running(false);
+    static std::mutex mutex;
+    static std::vector<ubyte> outbox;                        // serialized batches waiting to be sent
+    static std::vector<environment::Migrant> inbox;          // arrived migrants waiting to be spawned
+    static string coordinator_host;
+    static string coordinator_port;
+
+    /* SERIALIZATION */
+
+    static void put32(std::vector<ubyte> &out, uint32 value){
+        for(int i = 0; i < 4; i++){
+            out.push_back((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    static uint32 get32(const ubyte *in){
+        return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32)in[3] << 24);
+    }
+
+    static void serialize(const std::vector<environment::Migrant> &migrants, std::vector<ubyte> &out){
+        size_t header = out.size();
+        put32(out, MAGIC);
+        put32(out, migrants.size());
+        put32(out, 0);
+        size_t payload = out.size();
+        for(const environment::Migrant &migrant : migrants){
+            out.insert(out.end(), migrant.dna, migrant.dna + config::CREATURE_DNA_SIZE);
+            put32(out, (uint32)migrant.generations);
+            put32(out, (uint32)migrant.mutations);
+            size_t length = MIN(migrant.name.size(), (size_t)255);
+            out.push_back((ubyte)length);
+            out.insert(out.end(), migrant.name.begin(), migrant.name.begin() + length);
+        }
+        uint32 bytes = out.size() - payload;
+        for(int i = 0; i < 4; i++){
+            out[header + 8 + i] = (bytes >> (8 * i)) & 0xFF;
+        }
+    }
+
+    // size of the complete message at the front of buffer, 0 if incomplete, SIZE_MAX if corrupt
+    static size_t messageSize(const std::vector<ubyte> &buffer){
+        if(buffer.size() < HEADER_SIZE){
+            return 0;
+        }
+        if(get32(&buffer[0]) != MAGIC || get32(&buffer[8]) > MAX_PAYLOAD){
+            return SIZE_MAX;
+        }
+        size_t size = HEADER_SIZE + get32(&buffer[8]);
+        return buffer.size() >= size ? size : 0;
+    }
+
+    static bool deserialize(const ubyte *message, std::vector<environment::Migrant> &out){
+        uint32 count = get32(message + 4);
+        const ubyte *in = message + HEADER_SIZE;
+        const ubyte *end = in + get32(message + 8);
+        for(uint32 i = 0; i < count; i++){
+            if(end - in < config::CREATURE_DNA_SIZE + 9){
+                return false;
+            }
+            environment::Migrant migrant;
+            memcpy(migrant.dna, in, config::CREATURE_DNA_SIZE);
+            in += config::CREATURE_DNA_SIZE;
+            migrant.generations = (int)get32(in);
+            migrant.mutations = (int)get32(in + 4);
+            size_t length = in[8];
+            in += 9;
+            if(end - in < (ptrdiff_t)length){
+                return false;
+            }
+            migrant.name.assign((const char*)in, length);
+            in += length;
+            out.push_back(migrant);
+        }
+        return true;
+    }
+
+    /* SOCKETS */
+
+    static void startSockets(){
+#ifdef _WIN32
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+#elif !defined(MSG_NOSIGNAL)
+        signal(SIGPIPE, SIG_IGN);
+#endif
+    }
+
+    static void stopSockets(){
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    static bool sendAll(Socket s, const ubyte *data, size_t size){
+        while(size > 0){
+            int sent = send(s, (const char*)data, (int)MIN(size, (size_t)65536), SEND_FLAGS);
+            if(sent <= 0){
+                return false;
+            }
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    // appends what is available without blocking longer than timeout, false if the connection closed
+    static bool receiveSome(Socket s, std::vector<ubyte> &buffer, int timeout_ms){
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s, &readable);
+        timeval timeout = {0, timeout_ms * 1000};
+        if(select((int)s + 1, &readable, nullptr, nullptr, &timeout) <= 0){
+            return true;
+        }
+        ubyte chunk[16384];
+        int received = recv(s, (char*)chunk, sizeof(chunk), 0);
+        if(received <= 0){
+            return false;
+        }
+        buffer.insert(buffer.end(), chunk, chunk + received);
+        return true;
+    }
+
+    static Socket connectTo(const string &host, const string &port){
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result = nullptr;
+        if(getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0){
+            return INVALID_SOCKET;
+        }
+        Socket s = INVALID_SOCKET;
+        for(addrinfo *a = result; a != nullptr && s == INVALID_SOCKET; a = a->ai_next){
+            s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+            if(s != INVALID_SOCKET && connect(s, a->ai_addr, (int)a->ai_addrlen) != 0){
+                closeSocket(s);
+                s = INVALID_SOCKET;
+            }
+        }
+        freeaddrinfo(result);
+        if(s != INVALID_SOCKET){
+            int flag = 1;
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag, sizeof(flag));
+        }
+        return s;
+    }
+
+    /* PEER */
+
+    static void networkLoop(){
+        Socket s = INVALID_SOCKET;
+        std::vector<ubyte> received;
+        std::vector<ubyte> sending;
+        std::vector<environment::Migrant> arrived;
+
+        while(running){
+            if(s == INVALID_SOCKET){
+                s = connectTo(coordinator_host, coordinator_port);
+                if(s == INVALID_SOCKET){
+                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                    continue;
+                }
+                received.clear();
+                cout << TERMINAL_COLOR << "[migration] connected to " << coordinator_host << ":" << coordinator_port << TERMINAL_CLEAR << endl;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                sending.swap(outbox);
+            }
+            bool alive = sending.empty() || sendAll(s, sending.data(), sending.size());
+            sending.clear();
+            alive = alive && receiveSome(s, received, 50);
+
+            size_t size;
+            while(alive && (size = messageSize(received)) != 0){
+                if(size == SIZE_MAX || !deserialize(received.data(), arrived)){
+                    alive = false;
+                    break;
+                }
+                received.erase(received.begin(), received.begin() + size);
+            }
+            if(!arrived.empty()){
+                std::lock_guard<std::mutex> lock(mutex);
+                inbox.insert(inbox.end(), arrived.begin(), arrived.end());
+                arrived.clear();
+            }
+
+            if(!alive){
+                cout << TERMINAL_COLOR << "[migration] lost connection, reconnecting" << TERMINAL_CLEAR << endl;
+                closeSocket(s);
+                s = INVALID_SOCKET;
+            }
+        }
+        if(s != INVALID_SOCKET){
+            closeSocket(s);
+        }
+    }
+
+    void initialize(const string &address){
+        size_t colon = address.rfind(':');
+        coordinator_host = colon == string::npos ? "127.0.0.1" : address.substr(0, colon);
+        coordinator_port = colon == string::npos ? address : address.substr(colon + 1);
+        startSockets();
+        running = true;
+        network_thread = std::thread(networkLoop);
+        cout << TERMINAL_COLOR << "[migration] intitialized" << TERMINAL_CLEAR << endl;
+    }
+
+    void cleanup(){
+        if(!running){
+            return;
+        }
+        running = false;
+        network_thread.join();
+        stopSockets();
+        cout << TERMINAL_COLOR << "[migration] cleanup" << TERMINAL_CLEAR << endl;
+    }
+
+    bool isEnabled(){
+        return running;
+    }
+
+    void update(uint64 tick){
+        if(!running){
+            return;
+        }
+
+        if(tick % config::ISLAND_MIGRATION_INTERVAL == 0 && tick > 0){
+            std::vector<environment::Migrant> migrants;
+            environment::emigrate(config::ISLAND_MIGRANTS, migrants);
+            std::vector<ubyte> batch;
+            serialize(migrants, batch);
+            std::lock_guard<std::mutex> lock(mutex);
+            outbox.insert(outbox.end(), batch.begin(), batch.end());
+        }
+
+        // the network thread only holds the lock to swap buffers, skip a tick rather than wait
+        std::vector<environment::Migrant> arrived;
+        if(mutex.try_lock()){
+            arrived.swap(inbox);
+            mutex.unlock();
+        }
+        if(!arrived.empty()){
+            environment::immigrate(arrived);
+        }
+    }
+
+    /* COORDINATOR */
+
+    void runCoordinator(int port){
+        startSockets();
+        Socket listener = socket(AF_INET, SOCK_STREAM, 0);
+        int flag = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&flag, sizeof(flag));
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons((unsigned short)port);
+        if(bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 16) != 0){
+            cout << TERMINAL_COLOR << "[migration] could not listen on port " << port << TERMINAL_CLEAR << endl;
+            closeSocket(listener);
+            stopSockets();
+            return;
+        }
+        cout << TERMINAL_COLOR << "[migration] coordinator listening on port " << port << TERMINAL_CLEAR << endl;
+
+        struct Peer {
+            Socket socket;
+            std::vector<ubyte> received;
+            bool dead;
+        };
+        std::vector<Peer> peers;
+
+        while(true){
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener, &readable);
+            Socket highest = listener;
+            for(Peer &peer : peers){
+                FD_SET(peer.socket, &readable);
+                highest = MAX(highest, peer.socket);
+            }
+            if(select((int)highest + 1, &readable, nullptr, nullptr, nullptr) <= 0){
+                continue;
+            }
+
+            if(FD_ISSET(listener, &readable)){
+                Socket s = accept(listener, nullptr, nullptr);
+                if(s != INVALID_SOCKET){
+                    peers.push_back({s, {}, false});
+                    cout << TERMINAL_COLOR << "[migration] peer joined, " << peers.size() << " connected" << TERMINAL_CLEAR << endl;
+                }
+            }
+
+            for(size_t i = 0; i < peers.size(); i++){
+                if(peers[i].dead || !FD_ISSET(peers[i].socket, &readable)){
+                    continue;
+                }
+                ubyte chunk[16384];
+                int received = recv(peers[i].socket, (char*)chunk, sizeof(chunk), 0);
+                bool alive = received > 0;
+                if(alive){
+                    peers[i].received.insert(peers[i].received.end(), chunk, chunk + received);
+                }
+
+                // forward whole batches to the next peer of the ring
+                size_t size;
+                while(alive && (size = messageSize(peers[i].received)) != 0){
+                    if(size == SIZE_MAX){
+                        alive = false;
+                        break;
+                    }
+                    Peer &next = peers[(i + 1) % peers.size()];
+                    if(!next.dead && !sendAll(next.socket, peers[i].received.data(), size)){
+                        next.dead = true;
+                    }
+                    peers[i].received.erase(peers[i].received.begin(), peers[i].received.begin() + size);
+                }
+                if(!alive){
+                    peers[i].dead = true;
+                }
+            }
+
+            // dropped after the pass, a peer may also die when the one before it forwards
+            for(size_t i = 0; i < peers.size(); i++){
+                if(peers[i].dead){
+                    closeSocket(peers[i].socket);
+                    peers.erase(peers.begin() + i);
+                    i--;
+                    cout << TERMINAL_COLOR << "[migration] peer left, " << peers.size() << " connected" << TERMINAL_CLEAR << endl;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Migration of genomes between worlds in separate processes over tcp */
+namespace migration {
+    static string TERMINAL_COLOR = "\033[1;32m";
+
+    // connects this process to a coordinator at host:port, all socket io runs on a background thread
+    void initialize(const string &address);
+
+    void cleanup();
+
+    bool isEnabled();
+
+    // sends a batch of emigrants every ISLAND_MIGRATION_INTERVAL ticks and spawns arrived migrants, never blocks
+    void update(uint64 tick);
+
+    // relays batches between connected processes in a ring, runs until the process is killed
+    void runCoordinator(int port);
+}
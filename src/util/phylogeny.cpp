@@ -0,0 +1,198 @@
+#include "util/phylogeny.hpp"
+#include "ecs.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace phylogeny {
+
+    static constexpr size_t NONE = SIZE_MAX;
+    static const char MAGIC[8] = "EVOPHY1";
+
+    static size_t findIndex(const Tree &tree, uint64 id){
+        size_t low = 0;
+        size_t high = tree.nodes.size();
+        while(low < high){
+            size_t mid = (low + high) / 2;
+            if(tree.nodes[mid].id < id){
+                low = mid + 1;
+            }else{
+                high = mid;
+            }
+        }
+        return low < tree.nodes.size() && tree.nodes[low].id == id ? low : NONE;
+    }
+
+    void clear(){
+        Tree &tree = ecs::world->phylogeny;
+        tree.nodes.clear();
+        tree.mutations.clear();
+        tree.next_id = 1;
+    }
+
+    uint64 recordBirth(uint64 parent, uint64 tick, const uint16 *mutations, int count){
+        Tree &tree = ecs::world->phylogeny;
+
+        // sorted with double flips removed, so positions compose by symmetric difference
+        static thread_local std::vector<uint16> flips;
+        flips.assign(mutations, mutations + count);
+        std::sort(flips.begin(), flips.end());
+        size_t kept = 0;
+        for(size_t i = 0; i < flips.size(); i++){
+            if(i + 1 < flips.size() && flips[i] == flips[i + 1]){
+                i++;
+                continue;
+            }
+            flips[kept++] = flips[i];
+        }
+
+        Node node;
+        node.id = tree.next_id++;
+        node.parent = parent;
+        node.tick = tick;
+        node.generations = 1;
+        node.mutation_count = kept;
+        node.mutation_offset = tree.mutations.size();
+        for(size_t i = 0; i < kept; i++){
+            tree.mutations.push_back(flips[i]);
+        }
+        tree.nodes.push_back(node);
+        return node.id;
+    }
+
+    void prune(){
+        Tree &tree = ecs::world->phylogeny;
+        size_t n = tree.nodes.size();
+
+        static thread_local std::vector<size_t> parent_index;
+        static thread_local std::vector<uint32> useful_children;
+        static thread_local std::vector<ubyte> alive;
+        parent_index.resize(n);
+        useful_children.assign(n, 0);
+        alive.assign(n, 0);
+
+        for(size_t i = 0; i < n; i++){
+            parent_index[i] = findIndex(tree, tree.nodes[i].parent);
+        }
+        for(const ecs::CreatureData &creature : ecs::world->creature_data.vector){
+            size_t i = findIndex(tree, creature.lineage);
+            if(i != NONE){
+                alive[i] = 1;
+            }
+        }
+
+        // children come after their parents, one backwards pass counts branches leading to alive creatures
+        for(size_t i = n; i-- > 0;){
+            bool useful = alive[i] || useful_children[i] > 0;
+            if(useful && parent_index[i] != NONE){
+                useful_children[parent_index[i]]++;
+            }
+        }
+
+        // an unbranched dead ancestor is folded into its only useful child
+        struct Carry {
+            uint64 parent;
+            uint32 generations;
+            std::vector<uint16> mutations;
+        };
+        std::unordered_map<size_t, Carry> carried;
+        static thread_local Tree pruned;
+        pruned.nodes.clear();
+        pruned.mutations.clear();
+        pruned.next_id = tree.next_id;
+        std::vector<uint16> own;
+        std::vector<uint16> merged;
+
+        for(size_t i = 0; i < n; i++){
+            if(!alive[i] && useful_children[i] == 0){
+                continue;
+            }
+            const Node &node = tree.nodes[i];
+            Carry carry = {node.parent, 0, {}};
+            auto from_parent = parent_index[i] != NONE ? carried.find(parent_index[i]) : carried.end();
+            if(from_parent != carried.end()){
+                carry = std::move(from_parent->second);
+                carried.erase(from_parent);
+            }else if(parent_index[i] == NONE){
+                carry.parent = INVALID_LINEAGE;
+            }
+
+            own.clear();
+            for(uint32 m = 0; m < node.mutation_count; m++){
+                own.push_back(tree.mutations[node.mutation_offset + m]);
+            }
+            merged.clear();
+            std::set_symmetric_difference(carry.mutations.begin(), carry.mutations.end(), own.begin(), own.end(), std::back_inserter(merged));
+
+            if(!alive[i] && useful_children[i] == 1){
+                carried[i] = {carry.parent, carry.generations + node.generations, merged};
+                continue;
+            }
+
+            Node kept = node;
+            kept.parent = carry.parent;
+            kept.generations = carry.generations + node.generations;
+            kept.mutation_count = merged.size();
+            kept.mutation_offset = pruned.mutations.size();
+            for(uint16 m : merged){
+                pruned.mutations.push_back(m);
+            }
+            pruned.nodes.push_back(kept);
+        }
+
+        std::swap(tree.nodes, pruned.nodes);
+        std::swap(tree.mutations, pruned.mutations);
+    }
+
+    const Node* findNode(uint64 id){
+        const Tree &tree = ecs::world->phylogeny;
+        size_t i = findIndex(tree, id);
+        return i != NONE ? &tree.nodes[i] : nullptr;
+    }
+
+    void lineage(uint64 id, std::vector<uint64> &out){
+        out.clear();
+        for(const Node *node = findNode(id); node != nullptr; node = findNode(node->parent)){
+            out.push_back(node->id);
+        }
+    }
+
+    uint64 commonAncestor(uint64 a, uint64 b){
+        // the younger of the two is never an ancestor of the older, so always step the younger
+        while(a != b && a != INVALID_LINEAGE && b != INVALID_LINEAGE){
+            uint64 &younger = a > b ? a : b;
+            const Node *node = findNode(younger);
+            if(node == nullptr){
+                return INVALID_LINEAGE;
+            }
+            younger = node->parent;
+        }
+        return a == b ? a : INVALID_LINEAGE;
+    }
+
+    template <class T>
+    static void put(std::vector<ubyte> &out, const T &value){
+        const ubyte *bytes = reinterpret_cast<const ubyte*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void serialize(std::vector<ubyte> &out){
+        const Tree &tree = ecs::world->phylogeny;
+        out.assign(MAGIC, MAGIC + sizeof(MAGIC));
+        put(out, (uint32)tree.nodes.size());
+        put(out, (uint32)tree.mutations.size());
+        for(size_t i = 0; i < tree.nodes.size(); i++){
+            const Node &node = tree.nodes[i];
+            put(out, node.id);
+            put(out, node.parent);
+            put(out, node.tick);
+            put(out, node.generations);
+            put(out, node.mutation_count);
+        }
+        for(size_t i = 0; i < tree.nodes.size(); i++){
+            const Node &node = tree.nodes[i];
+            for(uint32 m = 0; m < node.mutation_count; m++){
+                put(out, tree.mutations[node.mutation_offset + m]);
+            }
+        }
+    }
+}
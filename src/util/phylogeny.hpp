@@ -0,0 +1,82 @@
+#pragma once
+#include "engine/common.hpp"
+#include "config.hpp"
+
+/* Parent links of every birth in the bound world, kept bounded by pruning extinct branches */
+namespace phylogeny {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    static constexpr uint64 INVALID_LINEAGE = 0;            // lineage ids start at 1, roots have this parent
+    static constexpr int ARENA_CHUNK = 4096;
+    static_assert(config::CREATURE_DNA_SIZE * 8 <= 65536, "mutated bit positions are stored as uint16");
+
+    // append-only storage in fixed chunks, growing never moves existing elements
+    template <class T>
+    struct Arena {
+        std::vector<std::unique_ptr<T[]>> chunks;
+        size_t count = 0;
+
+        T& operator[](size_t i){
+            return chunks[i / ARENA_CHUNK][i % ARENA_CHUNK];
+        }
+
+        const T& operator[](size_t i) const {
+            return chunks[i / ARENA_CHUNK][i % ARENA_CHUNK];
+        }
+
+        void push_back(const T &value){
+            if(count == chunks.size() * ARENA_CHUNK){
+                chunks.emplace_back(new T[ARENA_CHUNK]);
+            }
+            (*this)[count++] = value;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        // keeps the chunks for reuse
+        void clear(){
+            count = 0;
+        }
+    };
+
+    struct Node {
+        uint64 id;
+        uint64 parent;              // nearest kept ancestor
+        uint64 tick;                // birth tick
+        uint32 generations;         // births since parent, more than 1 once unbranched ancestors were pruned
+        uint32 mutation_count;      // bits flipped relative to parent
+        size_t mutation_offset;
+    };
+
+    // nodes are sorted by id because ids only grow and a parent is always older than its child
+    struct Tree {
+        Arena<Node> nodes;
+        Arena<uint16> mutations;
+        uint64 next_id = 1;
+    };
+
+    void clear();
+
+    // records a birth into the bound world, parent is INVALID_LINEAGE for spawned creatures
+    // mutations are dna bit positions, a position flipped twice cancels out
+    uint64 recordBirth(uint64 parent, uint64 tick, const uint16 *mutations, int count);
+
+    // drops nodes without alive descendants and merges unbranched ancestor chains,
+    // afterwards at most two nodes per alive creature remain
+    void prune();
+
+    const Node* findNode(uint64 id);
+
+    // ids from id up to its root, newest first
+    void lineage(uint64 id, std::vector<uint64> &out);
+
+    // INVALID_LINEAGE if both descend from different roots
+    uint64 commonAncestor(uint64 a, uint64 b);
+
+    // header: char magic[8] "EVOPHY1", uint32 node count, uint32 mutation count
+    // nodes:  uint64 id, uint64 parent, uint64 tick, uint32 generations, uint32 mutation count
+    // then every node's mutated bit positions as uint16, in node order, all native byte order
+    void serialize(std::vector<ubyte> &out);
+}
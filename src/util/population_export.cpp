@@ -0,0 +1,301 @@
+#include "util/population_export.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "util/phylogeny.hpp"
+#include "util/species.hpp"
+#include "util/files.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+
+namespace population_export {
+
+    /*
+        file layout, native byte order
+        header:  char magic[8] "EVOPOP1", uint32 flags, uint32 creature count, uint64 tick, uint64 seed,
+                 uint32 dna size, uint32 appendage slots
+        columns: uint32 byte length followed by the column, in this order
+                 f32 size, f32 carnivore, f32 metabolic_rate, f32 mutation_rate, f32 energy,
+                 i32 generations, i32 mutations, u64 lineage, i32 species, u8 state, u8 appendage types [count * slots, NONE padded],
+                 u32 name offsets [count + 1], name bytes, dna
+        dna is stored raw or, with FLAG_DNA_DELTA, every row xor'ed with the previous one and
+        runs of zero bytes written as 0, run length (1-255)
+        the phylogeny of the same tick is written next to it, see phylogeny::serialize
+    */
+    static const char MAGIC[8] = "EVOPOP1";
+    static constexpr uint32 FLAG_DNA_DELTA = 1;
+    static constexpr int SNAPSHOTS = 2;
+    static constexpr int DNA = config::CREATURE_DNA_SIZE;
+    static constexpr int SLOTS = config::CREATURE_MAX_APPENDAGES;
+
+    struct Snapshot {
+        uint64 tick = 0;
+        uint32 count = 0;
+        std::vector<float> size;
+        std::vector<float> carnivore;
+        std::vector<float> metabolic_rate;
+        std::vector<float> mutation_rate;
+        std::vector<float> energy;
+        std::vector<int32> generations;
+        std::vector<int32> mutations;
+        std::vector<uint64> lineage;
+        std::vector<int32> species;
+        std::vector<ubyte> state;
+        std::vector<ubyte> appendages;
+        std::vector<uint32> name_offsets;
+        std::vector<char> names;
+        std::vector<ubyte> dna;
+        std::vector<ubyte> phylogeny;
+    };
+
+    static int interval = 0;
+
+    // snapshots are filled on the simulation thread and handed to the writer
+    static Snapshot snapshots[SNAPSHOTS];
+    static std::queue<int> free_snapshots;
+    static std::queue<int> written_snapshots;
+    static std::mutex mutex;
+    static std::condition_variable export_signal;
+    static std::thread writer;
+    static bool writer_quit = false;
+
+    static uint64 exported = 0;
+    static uint64 dropped = 0;
+
+    static void writeSnapshots();
+
+    void initialize(){
+        for(int i = 0; i < SNAPSHOTS; i++){
+            free_snapshots.push(i);
+        }
+        writer_quit = false;
+        writer = std::thread(writeSnapshots);
+        cout << TERMINAL_COLOR << "[population_export] intitialized" << TERMINAL_CLEAR << endl;
+    }
+
+    void cleanup(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writer_quit = true;
+        }
+        export_signal.notify_one();
+        if(writer.joinable()){
+            writer.join();
+        }
+        cout << TERMINAL_COLOR << "[population_export] cleanup, " << exported << " snapshots, " << dropped << " dropped" << TERMINAL_CLEAR << endl;
+    }
+
+    void setInterval(int ticks){
+        interval = ticks;
+    }
+
+    bool isEnabled(){
+        return interval > 0;
+    }
+
+    static void fill(Snapshot &s, uint64 tick){
+        const std::vector<ecs::CreatureData> &creatures = ecs::world->creature_data.vector;
+        uint32 n = creatures.size();
+
+        s.tick = tick;
+        s.count = n;
+        s.size.resize(n);
+        s.carnivore.resize(n);
+        s.metabolic_rate.resize(n);
+        s.mutation_rate.resize(n);
+        s.energy.resize(n);
+        s.generations.resize(n);
+        s.mutations.resize(n);
+        s.lineage.resize(n);
+        s.species.resize(n);
+        s.state.resize(n);
+        s.appendages.assign(n * SLOTS, (ubyte)ecs::Appendage::NONE);
+        s.name_offsets.resize(n + 1);
+        s.names.clear();
+        s.dna.resize(n * DNA);
+
+        for(uint32 i = 0; i < n; i++){
+            const ecs::CreatureData &c = creatures[i];
+            s.size[i] = c.size;
+            s.carnivore[i] = c.carnivore;
+            s.metabolic_rate[i] = c.metabolic_rate;
+            s.mutation_rate[i] = c.mutation_rate;
+            s.energy[i] = c.energy;
+            s.generations[i] = c.generations;
+            s.mutations[i] = c.mutations;
+            s.lineage[i] = c.lineage;
+            s.species[i] = species::getSpecies(c.lineage);
+            s.state[i] = (ubyte)c.state;
+            for(int a = 0; a < c.appendage_count; a++){
+                s.appendages[i * SLOTS + a] = (ubyte)c.appendages[a].type;
+            }
+            s.name_offsets[i] = s.names.size();
+            s.names.insert(s.names.end(), c.name.begin(), c.name.end());
+            memcpy(&s.dna[i * DNA], c.dna, DNA);
+        }
+        s.name_offsets[n] = s.names.size();
+        phylogeny::serialize(s.phylogeny);
+    }
+
+    void update(uint64 tick){
+        if(interval <= 0 || tick % interval != 0){
+            return;
+        }
+
+        int slot = -1;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!free_snapshots.empty()){
+                slot = free_snapshots.front();
+                free_snapshots.pop();
+            }
+        }
+        if(slot == -1){
+            // writer is behind, skip instead of stalling the tick
+            dropped++;
+            return;
+        }
+
+        fill(snapshots[slot], tick);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written_snapshots.push(slot);
+        }
+        export_signal.notify_one();
+        exported++;
+    }
+
+    /* WRITER THREAD */
+
+    static void encodeDNA(const std::vector<ubyte> &dna, uint32 count, std::vector<ubyte> &out){
+        out.clear();
+        for(uint32 i = 0; i < count; i++){
+            const ubyte *row = &dna[i * DNA];
+            const ubyte *previous = i > 0 ? &dna[(i - 1) * DNA] : nullptr;
+            int run = 0;
+            for(int b = 0; b < DNA; b++){
+                ubyte delta = previous != nullptr ? row[b] ^ previous[b] : row[b];
+                if(delta == 0 && run < 255){
+                    run++;
+                    continue;
+                }
+                if(run > 0){
+                    out.push_back(0);
+                    out.push_back(run);
+                    run = 0;
+                }
+                if(delta == 0){
+                    run = 1;
+                }else{
+                    out.push_back(delta);
+                }
+            }
+            if(run > 0){
+                // runs never cross rows so a reader can decode row by row
+                out.push_back(0);
+                out.push_back(run);
+            }
+        }
+    }
+
+    template<typename T>
+    static void writeColumn(FILE *file, const T *data, size_t count){
+        uint32 bytes = count * sizeof(T);
+        fwrite(&bytes, sizeof(bytes), 1, file);
+        if(bytes > 0){
+            fwrite(data, 1, bytes, file);
+        }
+    }
+
+    static bool writeSnapshot(const Snapshot &s, std::vector<ubyte> &encoded, const char *path){
+        FILE *file = fopen(path, "wb");
+        if(file == nullptr){
+            return false;
+        }
+
+        uint32 flags = config::POPULATION_EXPORT_DELTA ? FLAG_DNA_DELTA : 0;
+        uint64 seed = config::SIM_SEED;
+        uint32 dna_size = DNA;
+        uint32 slots = SLOTS;
+        fwrite(MAGIC, 1, sizeof(MAGIC), file);
+        fwrite(&flags, sizeof(flags), 1, file);
+        fwrite(&s.count, sizeof(s.count), 1, file);
+        fwrite(&s.tick, sizeof(s.tick), 1, file);
+        fwrite(&seed, sizeof(seed), 1, file);
+        fwrite(&dna_size, sizeof(dna_size), 1, file);
+        fwrite(&slots, sizeof(slots), 1, file);
+
+        writeColumn(file, s.size.data(), s.count);
+        writeColumn(file, s.carnivore.data(), s.count);
+        writeColumn(file, s.metabolic_rate.data(), s.count);
+        writeColumn(file, s.mutation_rate.data(), s.count);
+        writeColumn(file, s.energy.data(), s.count);
+        writeColumn(file, s.generations.data(), s.count);
+        writeColumn(file, s.mutations.data(), s.count);
+        writeColumn(file, s.lineage.data(), s.count);
+        writeColumn(file, s.species.data(), s.count);
+        writeColumn(file, s.state.data(), s.count);
+        writeColumn(file, s.appendages.data(), s.appendages.size());
+        writeColumn(file, s.name_offsets.data(), s.name_offsets.size());
+        writeColumn(file, s.names.data(), s.names.size());
+        if(flags & FLAG_DNA_DELTA){
+            encodeDNA(s.dna, s.count, encoded);
+            writeColumn(file, encoded.data(), encoded.size());
+        }else{
+            writeColumn(file, s.dna.data(), s.dna.size());
+        }
+
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    static bool writeBytes(const std::vector<ubyte> &bytes, const char *path){
+        FILE *file = fopen(path, "wb");
+        if(file == nullptr){
+            return false;
+        }
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+    static void writeSnapshots(){
+        std::vector<ubyte> encoded;
+        bool directory = false;
+        char path[256];
+
+        while(true){
+            int slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                export_signal.wait(lock, []{ return writer_quit || !written_snapshots.empty(); });
+                if(written_snapshots.empty()){
+                    break;
+                }
+                slot = written_snapshots.front();
+                written_snapshots.pop();
+            }
+
+            if(!directory){
+                files::makeDirectory(config::POPULATION_EXPORT_DIRECTORY);
+                directory = true;
+            }
+            snprintf(path, sizeof(path), "%spopulation_%08llu.evp", config::POPULATION_EXPORT_DIRECTORY.c_str(), (unsigned long long)snapshots[slot].tick);
+            if(!writeSnapshot(snapshots[slot], encoded, path)){
+                cout << TERMINAL_COLOR << "[population_export] ERROR! could not write " << path << TERMINAL_CLEAR << endl;
+            }
+            snprintf(path, sizeof(path), "%sphylogeny_%08llu.evl", config::POPULATION_EXPORT_DIRECTORY.c_str(), (unsigned long long)snapshots[slot].tick);
+            if(!writeBytes(snapshots[slot].phylogeny, path)){
+                cout << TERMINAL_COLOR << "[population_export] ERROR! could not write " << path << TERMINAL_CLEAR << endl;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            free_snapshots.push(slot);
+        }
+    }
+}
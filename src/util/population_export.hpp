@@ -0,0 +1,19 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Periodic columnar dump of every creature's genome and traits for offline analysis */
+namespace population_export {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    void initialize();
+
+    void cleanup();
+
+    // interval <= 0 disables the export
+    void setInterval(int ticks);
+
+    bool isEnabled();
+
+    // snapshots the bound world every interval ticks, compression and file io run on a writer thread
+    void update(uint64 tick);
+}
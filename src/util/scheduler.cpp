@@ -0,0 +1,109 @@
+#include "util/scheduler.hpp"
+#include "engine/common.hpp"
+#include "config.hpp"
+#include <chrono>
+
+namespace scheduler {
+
+    typedef std::chrono::steady_clock Clock;
+
+    static const float speeds[] = {1.0f, 2.0f, 10.0f, SPEED_MAX};
+    static constexpr int SPEED_COUNT = sizeof(speeds) / sizeof(speeds[0]);
+
+    static float speed = 1.0f;
+    static double owed = 0.0;                   // simulated seconds not yet ticked
+    static bool clock_started = false;
+    static Clock::time_point last_frame;
+    static Clock::time_point frame_start;
+    static float frame_time = 0.0f;
+    static int frame_ticks = 0;
+
+    // achieved speed window
+    static double window_time = 0.0;
+    static uint64 window_ticks = 0;
+    static float achieved = 0.0f;
+
+    static double elapsed(Clock::time_point start, Clock::time_point end){
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    void setSpeed(float s){
+        speed = s;
+        owed = 0.0;
+    }
+
+    float getSpeed(){
+        return speed;
+    }
+
+    void cycleSpeed(){
+        int next = 0;
+        for(int i = 0; i < SPEED_COUNT; i++){
+            if(speeds[i] == speed){
+                next = (i + 1) % SPEED_COUNT;
+            }
+        }
+        setSpeed(speeds[next]);
+    }
+
+    bool beginFrame(){
+        Clock::time_point now = Clock::now();
+        if(!clock_started){
+            clock_started = true;
+            last_frame = now;
+        }
+        double real_delta = elapsed(last_frame, now);
+
+        // frames run at the tick rate, faster speeds run more ticks per frame instead of more frames
+        bool due = speed == SPEED_MAX || real_delta >= config::SIM_DELTA;
+        if(!due){
+            return false;
+        }
+
+        if(speed != SPEED_MAX){
+            // a simulation slower than the target drops the backlog instead of spiralling
+            owed = MIN(owed + real_delta * speed, (double)config::SIM_MAX_FRAME_TIME * speed);
+        }
+
+        window_time += real_delta;
+        window_ticks += frame_ticks;
+        if(window_time >= 0.5){
+            achieved = window_ticks * config::SIM_DELTA / window_time;
+            window_time = 0.0;
+            window_ticks = 0;
+        }
+
+        frame_time = real_delta;
+        frame_ticks = 0;
+        last_frame = now;
+        frame_start = now;
+        return true;
+    }
+
+    float getFrameTime(){
+        return frame_time;
+    }
+
+    bool nextTick(){
+        // the first owed tick always runs, so even a tick slower than the budget makes progress
+        if(frame_ticks > 0 && elapsed(frame_start, Clock::now()) >= config::SIM_FRAME_BUDGET){
+            return false;
+        }
+        if(speed != SPEED_MAX){
+            if(owed < config::SIM_DELTA){
+                return false;
+            }
+            owed -= config::SIM_DELTA;
+        }
+        frame_ticks++;
+        return true;
+    }
+
+    void skipFrame(){
+        owed = 0.0;
+    }
+
+    float getAchievedSpeed(){
+        return achieved;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Frame pacing of the windowed main loop, runs as many ticks per rendered frame as the speed and frame budget allow */
+namespace scheduler {
+
+    static constexpr float SPEED_MAX = 0.0f;        // no target, ticks until the frame budget is spent
+
+    // simulated seconds per real second, or SPEED_MAX
+    void setSpeed(float speed);
+
+    float getSpeed();
+
+    // next of 1x, 2x, 10x and max
+    void cycleSpeed();
+
+    // true once per tick interval, always at max speed, call every loop iteration
+    bool beginFrame();
+
+    // real seconds since the last frame began
+    float getFrameTime();
+
+    // true while another tick is owed and fits into the frame budget, consumes it
+    bool nextTick();
+
+    // drops the owed ticks of this frame, used while paused
+    void skipFrame();
+
+    // simulated seconds per real second, measured over the last half second
+    float getAchievedSpeed();
+}
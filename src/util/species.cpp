@@ -0,0 +1,222 @@
+#include "util/species.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include "util/phylogeny.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <cstring>
+
+// hardware popcount, gcc and clang only emit the instruction for functions targeting it
+#ifdef _MSC_VER
+#include <intrin.h>
+#define popcount64(x) (uint32)__popcnt64(x)
+#define POPCOUNT_KERNEL
+#else
+#define popcount64(x) (uint32)__builtin_popcountll(x)
+#define POPCOUNT_KERNEL __attribute__((target("popcnt")))
+#endif
+
+namespace species {
+
+    static constexpr int DNA = config::CREATURE_DNA_SIZE;
+    static_assert(DNA % 32 == 0, "distance kernel compares 32 bytes per step");
+
+    // dna of the living creatures at one tick, filled by the simulation thread
+    struct Snapshot {
+        std::vector<uint64> lineage;
+        std::vector<uint64> parent;
+        std::vector<ubyte> dna;
+    };
+
+    // first member of a species, later creatures join the nearest representative in range
+    struct Representative {
+        int id;
+        int members;
+        ubyte dna[DNA];
+    };
+
+    static Snapshot snapshot;
+    static bool snapshot_ready = false;
+    static bool worker_busy = false;
+    static std::mutex mutex;
+    static std::condition_variable worker_signal;
+    static std::thread worker;
+    static bool worker_quit = false;
+
+    // published results, guarded by mutex
+    static std::unordered_map<uint64, int> published;
+    static int published_count = 0;
+
+    // worker state, carried between passes so unchanged creatures are not searched again
+    static std::vector<Representative> representatives;
+    static std::unordered_map<uint64, int> assignment;
+    static int next_species = 0;
+
+    static void cluster();
+
+    void initialize(){
+        worker_quit = false;
+        worker = std::thread(cluster);
+        cout << TERMINAL_COLOR << "[species] intitialized" << TERMINAL_CLEAR << endl;
+    }
+
+    void cleanup(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            worker_quit = true;
+        }
+        worker_signal.notify_one();
+        if(worker.joinable()){
+            worker.join();
+        }
+        cout << TERMINAL_COLOR << "[species] cleanup" << TERMINAL_CLEAR << endl;
+    }
+
+    POPCOUNT_KERNEL uint32 distance(const ubyte *a, const ubyte *b){
+        uint32 bits = 0;
+        for(int i = 0; i < DNA; i += 32){
+            uint64 x[4];
+            uint64 y[4];
+            memcpy(x, a + i, 32);
+            memcpy(y, b + i, 32);
+            bits += popcount64(x[0] ^ y[0]) + popcount64(x[1] ^ y[1]) + popcount64(x[2] ^ y[2]) + popcount64(x[3] ^ y[3]);
+        }
+        return bits;
+    }
+
+    void update(uint64 tick){
+        if(tick % config::SPECIES_INTERVAL != 0){
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(worker_busy || snapshot_ready){
+                // previous pass still running, skip instead of stalling the tick
+                return;
+            }
+        }
+
+        const std::vector<ecs::CreatureData> &creatures = ecs::world->creature_data.vector;
+        size_t n = creatures.size();
+        snapshot.lineage.resize(n);
+        snapshot.parent.resize(n);
+        snapshot.dna.resize(n * DNA);
+        for(size_t i = 0; i < n; i++){
+            const phylogeny::Node *node = phylogeny::findNode(creatures[i].lineage);
+            snapshot.lineage[i] = creatures[i].lineage;
+            snapshot.parent[i] = node != nullptr ? node->parent : phylogeny::INVALID_LINEAGE;
+            memcpy(&snapshot.dna[i * DNA], creatures[i].dna, DNA);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            snapshot_ready = true;
+        }
+        worker_signal.notify_one();
+    }
+
+    int getSpecies(uint64 lineage){
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = published.find(lineage);
+        return it != published.end() ? it->second : NO_SPECIES;
+    }
+
+    int getSpeciesCount(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return published_count;
+    }
+
+    /* WORKER THREAD */
+
+    static std::unordered_map<int, int> representative_index;
+
+    static int findRepresentative(int id){
+        auto it = representative_index.find(id);
+        return it != representative_index.end() ? it->second : -1;
+    }
+
+    static void assign(const Snapshot &s, std::unordered_map<uint64, int> &result){
+        representative_index.clear();
+        for(size_t r = 0; r < representatives.size(); r++){
+            representatives[r].members = 0;
+            representative_index[representatives[r].id] = r;
+        }
+
+        size_t n = s.lineage.size();
+        for(size_t i = 0; i < n; i++){
+            const ubyte *dna = &s.dna[i * DNA];
+
+            // a creature usually stays in its last species and a newborn joins its parent's,
+            // only creatures that drifted out of range search all representatives
+            int r = -1;
+            auto previous = assignment.find(s.lineage[i]);
+            if(previous == assignment.end()){
+                previous = assignment.find(s.parent[i]);
+            }
+            if(previous != assignment.end()){
+                r = findRepresentative(previous->second);
+                if(r != -1 && distance(dna, representatives[r].dna) > config::SPECIES_DISTANCE){
+                    r = -1;
+                }
+            }
+            if(r == -1){
+                uint32 best = config::SPECIES_DISTANCE + 1;
+                for(size_t k = 0; k < representatives.size(); k++){
+                    uint32 d = distance(dna, representatives[k].dna);
+                    if(d < best){
+                        best = d;
+                        r = k;
+                    }
+                }
+            }
+            if(r == -1){
+                Representative founder;
+                founder.id = next_species++;
+                founder.members = 0;
+                memcpy(founder.dna, dna, DNA);
+                representatives.push_back(founder);
+                r = representatives.size() - 1;
+                representative_index[founder.id] = r;
+            }
+
+            representatives[r].members++;
+            result[s.lineage[i]] = representatives[r].id;
+        }
+
+        // extinct species
+        size_t kept = 0;
+        for(size_t r = 0; r < representatives.size(); r++){
+            if(representatives[r].members > 0){
+                representatives[kept++] = representatives[r];
+            }
+        }
+        representatives.resize(kept);
+    }
+
+    static void cluster(){
+        std::unordered_map<uint64, int> result;
+        while(true){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                worker_signal.wait(lock, []{ return worker_quit || snapshot_ready; });
+                if(worker_quit){
+                    break;
+                }
+                worker_busy = true;
+                snapshot_ready = false;
+            }
+
+            result.clear();
+            assign(snapshot, result);
+            assignment = result;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(published, result);
+            published_count = representatives.size();
+            worker_busy = false;
+        }
+    }
+}
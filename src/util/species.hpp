@@ -0,0 +1,24 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Clustering of living creatures into species by dna hamming distance */
+namespace species {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    static constexpr int NO_SPECIES = -1;
+
+    void initialize();
+
+    void cleanup();
+
+    // snapshots the bound world every SPECIES_INTERVAL ticks, clustering runs on a background thread
+    void update(uint64 tick);
+
+    // result of the last finished pass, NO_SPECIES for creatures born after its snapshot
+    int getSpecies(uint64 lineage);
+
+    int getSpeciesCount();
+
+    // number of differing bits between two dna arrays
+    uint32 distance(const ubyte *a, const ubyte *b);
+}
@@ -0,0 +1,85 @@
+#include "util/system_graph.hpp"
+#include "engine/common.hpp"
+#include "config.hpp"
+#include "util/allocations.hpp"
+#include "util/frame_arena.hpp"
+#include "util/thread_pool.hpp"
+#include "util/trace.hpp"
+
+namespace system_graph {
+
+    struct System {
+        const char *name;
+        Update update;
+        uint32 reads;
+        uint32 writes;
+        uint32 flags;
+    };
+
+    static std::vector<System> systems;
+    static std::vector<std::vector<int>> stages;
+
+    static bool conflicts(const System &a, const System &b){
+        return (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+    }
+
+    void add(const char *name, Update update, uint32 reads, uint32 writes, uint32 flags){
+        systems.push_back({name, update, reads, writes, flags});
+    }
+
+    static void runSystem(const System &system, uint64 tick){
+        // a system task may run on a worker, which releases its scratch memory right after
+        frame_arena::Scope scope;
+        uint64 allocated = allocations::getCount();
+        system.update(tick);
+        allocated = allocations::getCount() - allocated;
+        if(allocated > 0 && (system.flags & ALLOCATION_FREE) && tick >= config::ALLOCATION_WARMUP_TICKS){
+            cout << TERMINAL_COLOR << "[system_graph] " << system.name << " made " << allocated << " heap allocations in tick " << tick << TERMINAL_CLEAR << endl;
+            assert(false);
+        }
+    }
+
+    void build(){
+        // earliest stage after every conflicting predecessor, independent systems move up next to each other
+        std::vector<int> stage_of(systems.size(), 0);
+        stages.clear();
+        for(size_t i = 0; i < systems.size(); i++){
+            for(size_t j = 0; j < i; j++){
+                if(conflicts(systems[i], systems[j])){
+                    stage_of[i] = MAX(stage_of[i], stage_of[j] + 1);
+                }
+            }
+            if(stage_of[i] >= (int)stages.size()){
+                stages.resize(stage_of[i] + 1);
+            }
+            stages[stage_of[i]].push_back(i);
+        }
+
+        for(const std::vector<int> &stage : stages){
+            cout << TERMINAL_COLOR << "[system_graph] stage";
+            for(int i : stage){
+                cout << " " << systems[i].name;
+            }
+            cout << TERMINAL_CLEAR << endl;
+        }
+    }
+
+    void run(uint64 tick){
+        frame_arena::Scope scope;
+        for(const std::vector<int> &stage : stages){
+            // a single system runs on the caller, its own parallel loops get the whole pool
+            thread_pool::parallelFor(stage.size(), [&](int i){
+                runSystem(systems[stage[i]], tick);
+            });
+            for(int i : stage){
+                if(systems[i].flags & TRACED){
+                    trace::digest(systems[i].name, tick);
+                }
+            }
+        }
+    }
+
+    int getStageCount(){
+        return stages.size();
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Systems of one tick with the world data they touch, systems without conflicting access run concurrently */
+namespace system_graph {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    // world data a system reads or writes, conflicts are decided per flag
+    enum Resource : uint32 {
+        ENTITIES    = 1 << 0,   // allocation, component vector layout and the random stream
+        BODIES      = 1 << 1,
+        REGIONS     = 1 << 2,   // broadphase regions and the contact list of the last physics update
+        CREATURES   = 1 << 3,   // creature data except the brain
+        BRAINS      = 1 << 4,   // neurons of all creatures and their firing count
+        PARTICLES   = 1 << 5,
+        MESHES      = 1 << 6,
+        FOOD_FIELD  = 1 << 7,
+        HEATMAP     = 1 << 8,
+        ALL         = 0xFFFFFFFF
+    };
+
+    enum Flag : uint32 {
+        TRACED          = 1 << 0,   // digested by trace after its stage
+        ALLOCATION_FREE = 1 << 1,   // debug builds assert that it makes no heap allocations once warmed up
+    };
+
+    typedef void (*Update)(uint64 tick);
+
+    // in serial order, a system runs after every earlier system it conflicts with
+    void add(const char *name, Update update, uint32 reads, uint32 writes, uint32 flags = TRACED | ALLOCATION_FREE);
+
+    // groups the added systems into stages of mutually independent systems
+    void build();
+
+    // runs one tick of the bound world, stages in order and the systems of a stage on the thread pool
+    // frame_arena scratch memory of the tick is released when it returns
+    void run(uint64 tick);
+
+    int getStageCount();
+}
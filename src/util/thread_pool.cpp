@@ -0,0 +1,157 @@
+#include "util/thread_pool.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "util/allocations.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace thread_pool {
+
+    struct Job {
+        const std::function<void(int)> *task = nullptr;
+        ecs::World *world = nullptr;
+        int count = 0;
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+        std::atomic<uint64> allocated{0};   // by helping workers, credited to the caller
+    };
+
+    static std::vector<std::thread> workers;
+    static std::mutex mutex;
+    static std::condition_variable wake;
+    static std::condition_variable finished;
+    // jobs with tasks left, nested jobs are pushed on top and served first
+    // workers hold their own reference, a late worker only sees an exhausted job
+    static std::vector<std::shared_ptr<Job>> jobs;
+    // finished jobs for reuse, so a parallel loop does not allocate once the deepest nesting has been seen
+    static std::vector<std::shared_ptr<Job>> spare;
+    static bool running = false;
+
+    static void work(Job &job, bool helper){
+        ecs::World *old = ecs::world;
+        uint64 allocated = allocations::getCount();
+        int ran = 0;
+        for(int i = job.next++; i < job.count; i = job.next++){
+            ecs::bindWorld(job.world);
+            (*job.task)(i);
+            ran++;
+        }
+        ecs::bindWorld(old);
+        if(helper){
+            job.allocated += allocations::getCount() - allocated;
+        }
+        if(ran > 0 && (job.done += ran) == job.count){
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+
+    // caller holds the mutex
+    static void retire(const std::shared_ptr<Job> &job){
+        auto it = std::find(jobs.begin(), jobs.end(), job);
+        if(it != jobs.end()){
+            jobs.erase(it);
+        }
+    }
+
+    static void workerLoop(){
+        while(true){
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, []{ return !running || !jobs.empty(); });
+                if(!running){
+                    return;
+                }
+                job = jobs.back();
+            }
+            work(*job, true);
+            std::lock_guard<std::mutex> lock(mutex);
+            retire(job);
+        }
+    }
+
+    void initialize(int threads){
+        if(threads <= 0){
+            threads = MAX((int)std::thread::hardware_concurrency(), 1);
+        }
+        running = true;
+        // every worker holds at most one retired job, the rest covers nested loops
+        jobs.reserve(threads + 8);
+        spare.reserve(threads + 8);
+        for(int i = 0; i < threads + 8; i++){
+            spare.push_back(std::make_shared<Job>());
+        }
+        for(int i = 1; i < threads; i++){
+            workers.emplace_back(workerLoop);
+        }
+        cout << TERMINAL_COLOR << "[thread_pool] intitialized with " << threads << " threads" << TERMINAL_CLEAR << endl;
+    }
+
+    void cleanup(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        for(std::thread &worker : workers){
+            worker.join();
+        }
+        workers.clear();
+        spare.clear();
+        cout << TERMINAL_COLOR << "[thread_pool] cleanup" << TERMINAL_CLEAR << endl;
+    }
+
+    int getThreadCount(){
+        return (int)workers.size() + 1;
+    }
+
+    void parallelFor(int count, const std::function<void(int)> &task){
+        if(count <= 0){
+            return;
+        }
+        if(workers.empty() || count == 1){
+            for(int i = 0; i < count; i++){
+                task(i);
+            }
+            return;
+        }
+
+        std::shared_ptr<Job> job;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // a spare job only referenced by the pool is no longer seen by any late worker
+            for(std::shared_ptr<Job> &candidate : spare){
+                if(candidate.use_count() == 1){
+                    job = candidate;
+                    break;
+                }
+            }
+            if(!job){
+                job = std::make_shared<Job>();
+                spare.push_back(job);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            job->task = &task;
+            job->world = ecs::world;
+            job->count = count;
+            job->next = 0;
+            job->done = 0;
+            job->allocated = 0;
+            jobs.push_back(job);
+        }
+        wake.notify_all();
+
+        // the caller helps, then waits for stragglers, which never wait on this caller in turn
+        work(*job, false);
+        std::unique_lock<std::mutex> lock(mutex);
+        retire(job);
+        finished.wait(lock, [&]{ return job->done == job->count; });
+        // so the allocation check of a system also covers the tasks the workers ran for it
+        allocations::add(job->allocated);
+    }
+}
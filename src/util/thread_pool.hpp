@@ -0,0 +1,19 @@
+#pragma once
+#include "engine/common.hpp"
+#include <functional>
+
+/* Fixed set of worker threads for data parallel loops */
+namespace thread_pool {
+    static string TERMINAL_COLOR = "\033[1;30m";
+
+    // threads <= 0 uses one thread per core, the calling thread counts as one
+    void initialize(int threads);
+
+    void cleanup();
+
+    int getThreadCount();
+
+    // runs task(i) for every i in [0, count) and returns when all are done
+    // tasks run bound to the caller's ecs world, nested calls are shared with idle workers
+    void parallelFor(int count, const std::function<void(int)> &task);
+}
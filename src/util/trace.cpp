@@ -0,0 +1,192 @@
+#include "util/trace.hpp"
+#include "engine/common.hpp"
+#include "ecs.hpp"
+#include "config.hpp"
+#include <cstdio>
+
+namespace trace {
+
+    using namespace ecs;
+
+    // positions, energies, brain potentials, entity counts and states
+    static constexpr int PARTS = 4;
+    static const char *part_names[PARTS] = {"positions", "energies", "potentials", "counts"};
+
+    static constexpr char MAGIC[8] = {'E', 'V', 'O', 'T', 'R', 'A', 'C', 'E'};
+    static constexpr uint32 VERSION = 1;
+
+    struct Header {
+        char magic[8];
+        uint32 version;
+        uint32 seed;
+        uint32 systems;         // digests per tick
+        uint32 ticks;
+    };
+
+    static Mode mode = OFF;
+    static FILE *file = nullptr;
+    static string file_path;
+
+    static uint32 first_tick_systems = 0;
+    static std::vector<uint32> digests;        // PARTS words per digest
+    static size_t cursor = 0;
+    static Header header;
+    static bool matching = true;
+
+    static inline void mix(uint32 &h, uint32 word){
+        // FNV-1a over 32 bit words
+        h ^= word;
+        h *= 16777619u;
+    }
+
+    static inline void mix(uint32 &h, float value){
+        uint32 word;
+        memcpy(&word, &value, sizeof(word));
+        mix(h, word);
+    }
+
+    static void computeDigest(uint32 out[PARTS]){
+        for(int i = 0; i < PARTS; i++){
+            out[i] = 2166136261u;
+        }
+
+        for(const PhysicsBody &body : world->physics_bodies.vector){
+            mix(out[0], body.position.x);
+            mix(out[0], body.position.y);
+            mix(out[0], body.theta);
+        }
+
+        for(const CreatureData &creature : world->creature_data.vector){
+            mix(out[1], creature.energy);
+            for(int y = 0; y < config::BRAIN_FULL_SIZE; y++){
+                for(int x = 0; x < config::BRAIN_FULL_SIZE; x++){
+                    mix(out[2], creature.neurons[y][x].potential);
+                }
+            }
+            mix(out[3], (uint32)creature.state);
+        }
+        for(const ParticleData &particle : world->particle_data.vector){
+            mix(out[1], particle.energy);
+        }
+
+        mix(out[3], (uint32)world->entitiesAlive);
+        mix(out[3], (uint32)world->cellsAlive);
+    }
+
+    void record(const string &path){
+        cleanup();
+        file = fopen(path.c_str(), "wb");
+        if(file == nullptr){
+            cout << TERMINAL_COLOR << "[trace] could not write " << path << TERMINAL_CLEAR << endl;
+            return;
+        }
+        memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.seed = config::SIM_SEED;
+        header.systems = 0;
+        header.ticks = 0;
+        // header is rewritten with the final counts on cleanup
+        fwrite(&header, sizeof(header), 1, file);
+        file_path = path;
+        mode = RECORD;
+        cout << TERMINAL_COLOR << "[trace] recording to " << path << TERMINAL_CLEAR << endl;
+    }
+
+    bool verify(const string &path){
+        cleanup();
+        FILE *in = fopen(path.c_str(), "rb");
+        if(in == nullptr){
+            cout << TERMINAL_COLOR << "[trace] could not read " << path << TERMINAL_CLEAR << endl;
+            return false;
+        }
+        bool valid = fread(&header, sizeof(header), 1, in) == 1 && memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == VERSION;
+        if(valid){
+            digests.resize((size_t)header.ticks * header.systems * PARTS);
+            valid = fread(digests.data(), sizeof(uint32), digests.size(), in) == digests.size();
+        }
+        fclose(in);
+        if(!valid){
+            cout << TERMINAL_COLOR << "[trace] " << path << " is not a valid trace" << TERMINAL_CLEAR << endl;
+            digests.clear();
+            return false;
+        }
+        if(header.seed != config::SIM_SEED){
+            cout << TERMINAL_COLOR << "[trace] WARNING trace was recorded with seed " << header.seed << TERMINAL_CLEAR << endl;
+        }
+        mode = VERIFY;
+        matching = true;
+        cout << TERMINAL_COLOR << "[trace] verifying " << header.ticks << " ticks from " << path << TERMINAL_CLEAR << endl;
+        return true;
+    }
+
+    void cleanup(){
+        if(mode == RECORD && file != nullptr){
+            fseek(file, 0, SEEK_SET);
+            fwrite(&header, sizeof(header), 1, file);
+            fclose(file);
+            cout << TERMINAL_COLOR << "[trace] recorded " << header.ticks << " ticks to " << file_path << TERMINAL_CLEAR << endl;
+        }
+        if(mode == VERIFY && matching && header.systems > 0){
+            cout << TERMINAL_COLOR << "[trace] all " << cursor / (header.systems * PARTS) << " verified ticks match" << TERMINAL_CLEAR << endl;
+        }
+        file = nullptr;
+        mode = OFF;
+        first_tick_systems = 0;
+        digests.clear();
+        cursor = 0;
+    }
+
+    Mode getMode(){
+        return mode;
+    }
+
+    uint64 getTraceTicks(){
+        return mode == VERIFY ? header.ticks : 0;
+    }
+
+    bool isMatching(){
+        return matching;
+    }
+
+    void digest(const char *system, uint64 tick){
+        if(mode == OFF || !matching){
+            return;
+        }
+
+        // the first tick defines how many systems are digested per tick
+        if(tick == 0){
+            first_tick_systems++;
+        }
+
+        uint32 current[PARTS];
+        computeDigest(current);
+
+        if(mode == RECORD){
+            fwrite(current, sizeof(uint32), PARTS, file);
+            header.systems = first_tick_systems;
+            header.ticks = tick + 1;
+            return;
+        }
+
+        if(tick == 1 && first_tick_systems != header.systems){
+            matching = false;
+            cout << TERMINAL_COLOR << "[trace] trace has " << header.systems << " systems per tick, this build " << first_tick_systems << TERMINAL_CLEAR << endl;
+            return;
+        }
+        if(cursor + PARTS > digests.size()){
+            return;
+        }
+        const uint32 *expected = &digests[cursor];
+        cursor += PARTS;
+        string diverged = "";
+        for(int i = 0; i < PARTS; i++){
+            if(current[i] != expected[i]){
+                diverged += string(" ") + part_names[i];
+            }
+        }
+        if(!diverged.empty()){
+            matching = false;
+            cout << TERMINAL_COLOR << "[trace] diverged at tick " << tick << " after " << system << ":" << diverged << TERMINAL_CLEAR << endl;
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "engine/common.hpp"
+
+/* Per tick digests of the simulation state, recorded to a file and verified against later runs */
+namespace trace {
+    static string TERMINAL_COLOR = "\033[1;35m";
+
+    enum Mode {
+        OFF,
+        RECORD,
+        VERIFY
+    };
+
+    void record(const string &path);
+
+    // returns false if the trace could not be read
+    bool verify(const string &path);
+
+    void cleanup();
+
+    Mode getMode();
+
+    // ticks stored in the trace being verified
+    uint64 getTraceTicks();
+
+    // false once verification diverged
+    bool isMatching();
+
+    // digests the world after a system ran, call in the same order every tick
+    void digest(const char *system, uint64 tick);
+}